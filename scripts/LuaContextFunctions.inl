@@ -1,5 +1,9 @@
 #pragma once
 
+// The getters read the backend's WindowState snapshot through Context::, they don't query GLFW.
+// Scripts only call them from Init (registerScript(), before the context runs) and from their
+// event subscribers, which run on the frame thread.
+
 int l_getWindowSize(lua_State* L) {
     newVector(L, 2);
     auto vec = Context::getWindowSize();
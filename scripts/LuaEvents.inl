@@ -0,0 +1,175 @@
+#pragma once
+
+/// Pushes the registry table @p name, creating it if it doesn't exist yet.
+void pushRegistryTable(lua_State* L, const char* name) {
+    luaL_getsubtable(L, LUA_REGISTRYINDEX, name);
+}
+
+lua_Integer eventCallbackKey(Events::CustomEventId id, uint16_t priority) {
+    return (static_cast<lua_Integer>(id) << 16) | priority;
+}
+
+/// Number of lua_Numbers in the payload of custom event @p id, or 0 if lua can't use it.
+int luaEventValueCount(Events::CustomEventId id) {
+    uint32_t payloadSize = Events::getCustomEventPayloadSize(id);
+    if(payloadSize == 0 || payloadSize % sizeof(lua_Number) != 0 || payloadSize / sizeof(lua_Number) > static_cast<uint32_t>(g_maxLuaEventValues)) {
+        return 0;
+    }
+    return static_cast<int>(payloadSize / sizeof(lua_Number));
+}
+
+int l_registerEvent(lua_State* L) { // std::string name, int valueCount, [int capacity]
+    const char* name = luaL_checkstring(L, 1);
+    lua_Integer valueCount = luaL_checkinteger(L, 2);
+    lua_Integer capacity = luaL_optinteger(L, 3, g_customEventCapacity);
+    luaL_argcheck(L, valueCount > 0 && valueCount <= g_maxLuaEventValues, 2, "1 to 16 values expected");
+    luaL_argcheck(L, capacity > 0 && capacity <= UINT16_MAX, 3, "capacity out of range");
+
+    entt::hashed_string hashedName{name};
+    uint32_t payloadSize = static_cast<uint32_t>(valueCount * sizeof(lua_Number));
+    uint32_t registeredSize = Events::getCustomEventPayloadSize(hashedName.value());
+    luaL_argcheck(L, registeredSize == 0 || registeredSize == payloadSize, 2, "event is already registered with a different value count");
+
+    lua_pushinteger(L, Events::registerCustomEvent(hashedName, payloadSize, static_cast<uint32_t>(capacity)));
+    return 1;
+}
+int l_setEvent(lua_State* L) { // int id, number... values
+    auto id = static_cast<Events::CustomEventId>(luaL_checkinteger(L, 1));
+    int valueCount = luaEventValueCount(id);
+    luaL_argcheck(L, valueCount != 0, 1, "id from registerEvent expected");
+
+    lua_Number values[g_maxLuaEventValues];
+    for(int i = 0; i < valueCount; i++) {
+        values[i] = luaL_optnumber(L, i + 2, 0.0);    // missing values are 0
+    }
+    lua_pushboolean(L, Events::setCustomEventBytes(id, values));
+    return 1;
+}
+int l_subscribeEvent(lua_State* L) { // int id, int priority, function callback
+    auto id = static_cast<Events::CustomEventId>(luaL_checkinteger(L, 1));
+    lua_Integer priority = luaL_checkinteger(L, 2);
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+    int valueCount = luaEventValueCount(id);
+    luaL_argcheck(L, valueCount != 0, 1, "id from registerEvent expected");
+    luaL_argcheck(L, priority >= 0 && priority <= UINT16_MAX, 2, "priority out of range");
+
+    // The function lives in a registry table, so the callback only captures its key.
+    // It is called once per event in the batch. If it returns true for any of them, subscribers
+    // after this one don't get the batch.
+    auto callback = [L, id, priority, valueCount](const Events::CustomEventBatch& batch) -> bool {
+        _BIGG_PROFILE_CATEGORY_SCOPE("script", "custom event callback");
+
+        pushRegistryTable(L, g_EventCallbacksTableName);
+        lua_rawgeti(L, -1, eventCallbackKey(batch.m_id, static_cast<uint16_t>(priority)));
+
+        bool consumed = false;
+        for(uint32_t i = 0; i < batch.m_count; i++) {
+            const auto* values = static_cast<const lua_Number*>(batch.payload(i));
+            lua_pushvalue(L, -1);   // the function
+            for(int j = 0; j < valueCount; j++) {
+                lua_pushnumber(L, values[j]);
+            }
+            if(lua_pcall(L, valueCount, 1, 0)) {
+                BIGG_LOG_WARN("Lua callback for custom event {:d} failed: {:s}", id, lua_tostring(L, -1));
+                lua_pop(L, 1);  // pop the error message
+                continue;
+            }
+            consumed |= lua_toboolean(L, -1) != 0;
+            lua_pop(L, 1);  // pop the return value
+        }
+
+        lua_pop(L, 2);  // pop the function and the callback table
+        return consumed;
+    };
+    if(!Events::subscribeCustom(id, static_cast<uint16_t>(priority), callback)) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    pushRegistryTable(L, g_EventCallbacksTableName);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, eventCallbackKey(id, static_cast<uint16_t>(priority)));
+    lua_pop(L, 1);  // pop the callback table
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+int l_unsubscribeEvent(lua_State* L) { // int id, int priority
+    auto id = static_cast<Events::CustomEventId>(luaL_checkinteger(L, 1));
+    lua_Integer priority = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, priority >= 0 && priority <= UINT16_MAX, 2, "priority out of range");
+
+    bool unsubscribed = Events::unsubscribeCustom(id, static_cast<uint16_t>(priority));
+    if(unsubscribed) {
+        pushRegistryTable(L, g_EventCallbacksTableName);
+        lua_pushnil(L);
+        lua_rawseti(L, -2, eventCallbackKey(id, static_cast<uint16_t>(priority)));
+        lua_pop(L, 1);  // pop the callback table
+    }
+    lua_pushboolean(L, unsubscribed);
+    return 1;
+}
+
+int l_scheduleAfter(lua_State* L) { // number delay, function callback, [number period]
+    lua_Number delay = luaL_checknumber(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_Number period = luaL_optnumber(L, 3, 0.0);
+
+    lua_Integer key = ++g_nextLuaTimerKey;
+    pushRegistryTable(L, g_TimerCallbacksTableName);
+    lua_pushvalue(L, 2);
+    lua_rawseti(L, -2, key);
+    lua_pop(L, 1);  // pop the callback table
+
+    bool periodic = period > 0.0;
+    g_luaTimers[L][key] = Events::scheduleAfter(delay, [L, key, periodic]() {
+        _BIGG_PROFILE_CATEGORY_SCOPE("script", "timer callback");
+
+        pushRegistryTable(L, g_TimerCallbacksTableName);
+        lua_rawgeti(L, -1, key);
+        if(!periodic) {
+            // forget it before calling, the callback may schedule another timer.
+            lua_pushnil(L);
+            lua_rawseti(L, -3, key);
+            g_luaTimers[L].erase(key);
+        }
+        if(lua_pcall(L, 0, 0, 0)) {
+            BIGG_LOG_WARN("Lua timer callback failed: {:s}", lua_tostring(L, -1));
+            lua_pop(L, 1);  // pop the error message
+        }
+        lua_pop(L, 1);  // pop the callback table
+    }, period);
+
+    lua_pushinteger(L, key);
+    return 1;
+}
+int l_cancelTimer(lua_State* L) { // int timer
+    lua_Integer key = luaL_checkinteger(L, 1);
+
+    auto& timers = g_luaTimers[L];
+    auto it = timers.find(key);
+    if(it == timers.end()) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    bool cancelled = Events::cancelTimer(it->second);
+    timers.erase(it);
+
+    pushRegistryTable(L, g_TimerCallbacksTableName);
+    lua_pushnil(L);
+    lua_rawseti(L, -2, key);
+    lua_pop(L, 1);  // pop the callback table
+
+    lua_pushboolean(L, cancelled);
+    return 1;
+}
+void cancelLuaTimers(lua_State* L) {
+    auto it = g_luaTimers.find(L);
+    if(it == g_luaTimers.end()) {
+        return;
+    }
+    for(const auto& [key, timer] : it->second) {
+        Events::cancelTimer(timer);
+    }
+    g_luaTimers.erase(it);
+}
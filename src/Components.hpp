@@ -4,7 +4,11 @@
  */
 
 #pragma once
+#include "Functor.hpp"
+
+#include <entt/entt.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 struct Transform {
     Transform(glm::vec3 pos, glm::vec3 rot, glm::vec3 scale) : position(pos), rotation(rot), scale(scale) {}
@@ -12,37 +16,59 @@ struct Transform {
     glm::vec3 rotation{0, 0, 0};
     glm::vec3 scale{1, 1, 1};
 };
-struct ImplVertex {
-    float x, y, z;
-    uint32_t colour;
+/// Transform as of the previous tick. Context snapshots it before every TickEvent, so rendering can
+/// interpolate between the last two ticks with UpdateEvent::m_alpha.
+struct PreviousTransform {
+    Transform m_transform;
+};
+
+/// Blends the previous and current tick's transform. @p alpha is UpdateEvent::m_alpha.
+inline Transform interpolate(const Transform& previous, const Transform& current, float alpha) {
+    return Transform(previous.position + (current.position - previous.position) * alpha,
+                     previous.rotation + (current.rotation - previous.rotation) * alpha,
+                     previous.scale    + (current.scale    - previous.scale)    * alpha);
+}
+
+/// Opt-in late latching. Right before draw calls are submitted, input is re-sampled (see
+/// Context::latchInput()) and @c m_function may patch the transform which is drawn this frame, eg.
+/// to put a cursor-driven object where the cursor is now. The entity's Transform isn't changed.
+/// RenderMeshComponents gathers meshes on job workers, so @c m_function may run on any of them.
+struct LateLatch {
+    BIGGEngine::Functor<void(entt::entity, Transform&)> m_function;
+};
+
+/// Draws the Mesh entities into bgfx view @c m_viewID, from this entity's Transform::position
+/// (interpolated and late latched like a mesh's) looking at @c m_target. Views are drawn in ID order,
+/// all below g_uiViewID. Without any camera, RenderMeshComponents uses a default one on view 0.
+struct Camera {
+    uint16_t m_viewID = 0;
+    glm::vec4 m_viewport{0.0f, 0.0f, 1.0f, 1.0f};   // x, y, width, height in fractions of the framebuffer
+    float m_fieldOfView = 30.0f;                    // vertical, in degrees
+    float m_near = 0.1f;
+    float m_far = 100.0f;
+    glm::vec3 m_target{0.0f, 0.0f, 0.0f};
+    glm::vec3 m_up{0.0f, 1.0f, 0.0f};
+    uint32_t m_clearColour = 0x939762ff;            // RGBA
+    bool m_clear = true;    // clear colour and depth first, else only depth (eg. a minimap over another view)
 };
-typedef uint16_t ImplIndex;
+
+using MeshId = entt::hashed_string::hash_type;
+
+/// Draws the mesh registered under @c m_id in the MeshRegistry (Render/MeshRegistry.hpp), which
+/// holds the geometry once for every entity. To switch meshes replace() or patch() the component,
+/// which moves its reference to the new mesh and resets Bounds to the new mesh's. Don't change
+/// @c m_id in place without telling the registry.
 struct Mesh {
-    std::vector<ImplVertex> m_vertices{
-            {-1.0f,  1.0f,  1.0f, 0xff000000 },
-            { 1.0f,  1.0f,  1.0f, 0xff0000ff },
-            {-1.0f, -1.0f,  1.0f, 0xff00ff00 },
-            { 1.0f, -1.0f,  1.0f, 0xff00ffff },
-            {-1.0f,  1.0f, -1.0f, 0xffff0000 },
-            { 1.0f,  1.0f, -1.0f, 0xffff00ff },
-            {-1.0f, -1.0f, -1.0f, 0xffffff00 },
-            { 1.0f, -1.0f, -1.0f, 0xffffffff },
-
-    };
-    std::vector<ImplIndex> m_indices{
-            0, 1, 2,
-            1, 3, 2,
-            4, 6, 5,
-            5, 6, 7,
-            0, 2, 4,
-            4, 2, 6,
-            1, 5, 3,
-            5, 7, 3,
-            0, 4, 1,
-            4, 5, 1,
-            2, 3, 6,
-            6, 3, 7,
-    };
+    MeshId m_id = entt::hashed_string{"cube"}.value();
+};
+
+/// Bounding sphere around the mesh, in the entity's local space. Added with the Mesh component from
+/// the MeshRegistry's bounds of the mesh, unless the entity already has one, and reset when the
+/// Mesh switches to another mesh. Entities whose sphere is
+/// outside of a camera's frustum aren't drawn by it; entities without Bounds always are.
+struct Bounds {
+    glm::vec3 m_center{0.0f, 0.0f, 0.0f};
+    float m_radius = 0.0f;
 };
 
 struct LuaScript {
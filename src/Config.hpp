@@ -1,25 +1,63 @@
 #pragma once
 
 #include <stdint.h> // uint16_t, UINT16_MAX
+#include <stddef.h> // size_t
+
+/// Compile in per-subscriber dispatch timing (Events::getDispatchStats). Still has to be turned on
+/// at runtime with Events::setDispatchStatsEnabled. Define as 0 to remove it completely.
+#if !defined(BIGG_CONFIG_EVENT_STATS)
+#   if defined(NDEBUG)
+#       define BIGG_CONFIG_EVENT_STATS 0
+#   else
+#       define BIGG_CONFIG_EVENT_STATS 1
+#   endif
+#endif
 
 namespace BIGGEngine {
 
 /// Engine constants
 const double        g_ticksFrequency    = 20.0;
 const double        g_tickDeltaTime     = 1 / g_ticksFrequency;
+const uint32_t      g_maxTicksPerFrame  = 5;    // catch-up limit. Ticks beyond this are dropped.
 
 // const priority levels
 const uint16_t        g_contextPriority       = 0;
-const uint16_t        g_renderBaseBeginPriority = 1;
+const uint16_t        g_latencyPriority       = 1;  // input events, before anything can consume them
+const uint16_t        g_renderBaseBeginPriority = 2;
 const uint16_t        g_renderBaseEndPriority   = UINT16_MAX;
-const uint16_t        g_renderUIBeginPriority = 2;
+const uint16_t        g_renderUIBeginPriority = 3;
+const uint16_t        g_timersPriority        = 4;
 const uint16_t        g_renderUIEndPriority   = UINT16_MAX-1;
 const uint16_t        g_renderMeshComponentsPriority  = UINT16_MAX-2;
 
 /// Context constants
 const unsigned int  g_maxWindowCount    = 20;
+const double        g_targetFrameRate   = 60.0;     // default FramePacer target. 0 waits for input or the next tick instead.
+const uint32_t      g_framePacerHistory = 240;      // frames in FramePacer::getFrameStats()
+const double        g_backgroundFrameRate = 5.0;    // frame rate while the window is iconified or unfocused
+const double        g_backgroundWakeInterval = 0.01; // how often a throttled render thread mode engine checks if the window came back
+const double        g_inputPollRate     = 1000.0;   // how often input is polled between frames with Context::setHighFrequencyInput()
+
+/// Events constants
+const uint32_t      g_eventQueueCapacity = 16;  // default per-type queue size. Must be a power of two.
+const uint32_t      g_eventInboxCapacity = 64;  // default per-type capacity for events posted from other threads. Must be a power of two.
+const uint32_t      g_customEventCapacity = 256;  // default number of events per custom event type between two polls.
+const size_t        g_functorCapacity   = 6 * sizeof(void*);    // inline storage of a Functor (eg. event callbacks)
+
+/// Latency constants
+const uint32_t      g_latencyHistory    = 240;      // samples in Latency::getStats()
+const uint32_t      g_latencyHistogramBuckets = 50;
+const double        g_latencyHistogramBucket  = 2e-3;   // seconds per histogram bucket
+
+/// Jobs constants
+const uint32_t      g_jobWorkerCount    = 0;    // worker threads. 0 for one less than the number of cores.
+const uint32_t      g_jobGrainSize      = 64;   // default entities per job in Jobs::parallelForEach
 
 /// Renderer constants
 const bool          g_vSyncEnabled      = false;
+const int32_t       g_renderThreadWait  = 5;    // ms the render thread waits for a frame before it polls the window again
+const uint16_t      g_uiViewID          = 255;  // bgfx view of the ImGui overlay, drawn after every Camera's view
+const uint32_t      g_instancingMinCount = 8;   // smaller groups of the same mesh are drawn one by one instead of instanced
+const uint32_t      g_instanceBufferMinSize = 1024; // instances RenderMeshComponents' instance buffer starts with, it grows as needed
 
 } // namespace BIGGEngine
\ No newline at end of file
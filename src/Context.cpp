@@ -1,14 +1,50 @@
 #include "Context.hpp"
 
+#include "FramePacer.hpp"
+#include "Jobs.hpp"
+#include "Latency.hpp"
+#include "Recorder.hpp"
+
+#include <algorithm>    // for std::max
+#include <atomic>
+#include <cmath>        // for std::fmod
+
 namespace BIGGEngine {
 namespace Context {
 namespace {
     bx::AllocatorI* m_allocator;
+    ContextI* m_implementation = nullptr;
+
+    // Wall time which hasn't been simulated yet, in seconds. Simulation runs in fixed TickEvents
+    // of g_tickDeltaTime, so simulation time keeps up with wall time however long a frame takes.
+    double m_accumulator = 0.0;
+
+    RedrawMode m_redrawMode = RedrawMode::Continuous;
+    std::atomic<bool> m_redrawRequested{true};
+    bool m_draw = true;
+    bool m_throttled = false;
+    bool m_highFrequencyInput = false;
+
+    Functor<void()> m_renderFrame;
+
+    /// Runs before every other TickEvent subscriber, so PreviousTransform holds the state from
+    /// before this tick while the tick changes Transform.
+    bool snapshotTransforms(const TickEvent&) {
+        BIGG_PROFILE_RUN_FUNCTION;
+        auto& registry = ECS::get();
+        for(auto [entity, transform] : registry.view<Transform>().each()) {
+            registry.emplace_or_replace<PreviousTransform>(entity, transform);
+        }
+        return false;
+    }
 
 }   // anonymous namespace
 
     void init() {
         m_allocator = new bx::DefaultAllocator();
+        m_accumulator = 0.0;
+        m_redrawRequested = true;
+        Events::subscribe<TickEvent>(g_contextPriority, snapshotTransforms);
     }
     void shutdown() {
         delete m_allocator;
@@ -16,5 +52,131 @@ namespace {
     bx::AllocatorI* getAllocator() {
         return m_allocator;
     }
+
+    void setImplementation(ContextI* implementation) {
+        m_implementation = implementation;
+    }
+
+    void runFrame(double delta) {
+        // work other threads handed back to this one, eg. results of asset loading jobs
+        Jobs::runMainThreadJobs();
+
+        // move events posted by other threads into the queues. They are dispatched with this frame.
+        m_implementation->drainInbox();
+
+        // post the ticks which are due
+        m_accumulator += delta;
+        uint32_t ticks = 0;
+        while(m_accumulator >= g_tickDeltaTime && ticks < g_maxTicksPerFrame) {
+            Recorder::setEvent<TickEvent>(TickEvent{g_tickDeltaTime});
+            m_accumulator -= g_tickDeltaTime;
+            ticks++;
+        }
+        if(m_accumulator >= g_tickDeltaTime) {
+            // Too far behind, eg. after a stall. Catching up would make the next frames slow too,
+            // and fall further behind (spiral of death), so drop the rest.
+            BIGG_LOG_DEBUG("Dropped {:d} ticks.", static_cast<uint32_t>(m_accumulator / g_tickDeltaTime));
+            m_accumulator = std::fmod(m_accumulator, g_tickDeltaTime);
+        }
+
+        // The backends keep their window state in step with WindowIconifyEvent / WindowFocusEvent.
+        const bool iconified = m_implementation->getWindowIconified();
+        const bool wasThrottled = m_throttled;
+        m_throttled = iconified || !m_implementation->getWindowFocus();
+        if(wasThrottled && !m_throttled) {
+            // throttled frames aren't paced, the schedule is from before the throttling
+            FramePacer::restartSchedule();
+        }
+
+        // Input and window events may change what is drawn. Ticks only do if a system says so.
+        const uint64_t frameEvents = (uint64_t(1) << Events::eventIndex<TickEvent>) | (uint64_t(1) << Events::eventIndex<UpdateEvent>);
+        const bool dirty = (Events::getPendingMask() & ~frameEvents) != 0;
+        const bool requested = m_redrawRequested.exchange(false, std::memory_order_relaxed);
+        m_draw = !iconified && (m_redrawMode == RedrawMode::Continuous || dirty || requested);
+        if(dirty && m_redrawMode == RedrawMode::OnDemand) {
+            // pollEvents() dispatches UpdateEvent before input, so this frame draws what was there
+            // before the input was handled. Draw the next one too, which shows its effect.
+            m_redrawRequested.store(true, std::memory_order_relaxed);
+        }
+
+        // post an update event. Posted last since a recording treats it as the end of a frame.
+        Recorder::setEvent<UpdateEvent>(UpdateEvent{delta, m_accumulator / g_tickDeltaTime});
+
+        // poll ticks before everything else, so the frame sees the newest simulation state.
+        Events::pollEvent<TickEvent>();
+        if(ticks > 0) {
+            Latency::mark(Latency::Stage::Tick);
+        }
+        Events::pollEvents();
+    }
+
+    double getTimeUntilNextTick() {
+        return std::max(g_tickDeltaTime - m_accumulator, 0.0);
+    }
+
+    void setRedrawMode(RedrawMode mode) {
+        m_redrawMode = mode;
+    }
+    RedrawMode getRedrawMode() {
+        return m_redrawMode;
+    }
+    void requestRedraw() {
+        m_redrawRequested.store(true, std::memory_order_relaxed);
+    }
+    bool shouldDraw() {
+        return m_draw;
+    }
+    bool isThrottled() {
+        return m_throttled;
+    }
+
+    void setHighFrequencyInput(bool enabled) {
+        m_highFrequencyInput = enabled;
+        // otherwise the samples of one frame are merged into one event again.
+        Events::setCoalescePolicy<MousePositionEvent>(enabled ? Events::CoalescePolicy::None : Events::CoalescePolicy::Accumulate);
+    }
+    bool getHighFrequencyInput() {
+        return m_highFrequencyInput;
+    }
+
+    void setRenderThread(Functor<void()>&& renderFrame) {
+        m_renderFrame = std::move(renderFrame);
+    }
+    bool hasRenderThread() {
+        return static_cast<bool>(m_renderFrame);
+    }
+    void renderFrame() {
+        m_renderFrame();
+    }
+
+    // forward to the implementation
+
+    int run() { return m_implementation->run(); }
+    void* getNativeWindowHandle() { return m_implementation->getNativeWindowHandle(); }
+    void* getNativeDisplayHandle() { return m_implementation->getNativeDisplayHandle(); }
+
+    glm::ivec2 getWindowSize() { return m_implementation->getWindowSize(); }
+    glm::ivec2 getWindowFramebufferSize() { return m_implementation->getWindowFramebufferSize(); }
+    glm::vec2 getWindowContentScale() { return m_implementation->getWindowContentScale(); }
+    glm::ivec2 getWindowPosition() { return m_implementation->getWindowPosition(); }
+    bool getWindowIconified() { return m_implementation->getWindowIconified(); }
+    bool getWindowMaximized() { return m_implementation->getWindowMaximized(); }
+    bool getWindowVisible() { return m_implementation->getWindowVisible(); }
+    bool getWindowFocus() { return m_implementation->getWindowFocus(); }
+    ActionEnum getKey(KeyEnum key) { return m_implementation->getKey(key); }
+    glm::dvec2 getMousePosition() { return m_implementation->getMousePosition(); }
+    bool getMouseHover() { return m_implementation->getMouseHover(); }
+    ActionEnum getMouseButton(MouseButtonEnum button) { return m_implementation->getMouseButton(button); }
+    std::string getClipboardString() { return m_implementation->getClipboardString(); }
+
+    void latchInput() { m_implementation->latchInput(); }
+
+    void setWindowShouldClose(bool shouldClose) { m_implementation->setWindowShouldClose(shouldClose); }
+    void setWindowSizeLimits(int minWidth, int minHeight, int maxWidth, int maxHeight) { m_implementation->setWindowSizeLimits(minWidth, minHeight, maxWidth, maxHeight); }
+    void setWindowAspectRatio(int numerator, int denominator) { m_implementation->setWindowAspectRatio(numerator, denominator); }
+    void setWindowTitle(std::string title) { m_implementation->setWindowTitle(std::move(title)); }
+    void setWindowVisible(bool visible) { m_implementation->setWindowVisible(visible); }
+    void setClipboardString(std::string text) { m_implementation->setClipboardString(std::move(text)); }
+
 }   // namespace Context
 }   // namespace BIGGEngine
@@ -8,7 +8,95 @@ namespace Context {
     void init();        // new m_allocator
     void shutdown();    // delete m_allocator
 
-    // an implementation must implement these functions:
+    /// A context backend, ie. ContextImplGLFW or ContextImplHeadless. Its init() installs it with
+    /// setImplementation(), then the functions below forward to it. Chosen at startup, so one build
+    /// can run with a window or without one.
+    struct ContextI {
+        virtual ~ContextI() = default;
+
+        virtual int run() = 0;
+        virtual void* getNativeWindowHandle() = 0;
+        virtual void* getNativeDisplayHandle() = 0;
+
+        virtual glm::ivec2 getWindowSize() = 0;
+        virtual glm::ivec2 getWindowFramebufferSize() = 0;
+        virtual glm::vec2 getWindowContentScale() = 0;
+        virtual glm::ivec2 getWindowPosition() = 0;
+        virtual bool getWindowIconified() = 0;
+        virtual bool getWindowMaximized() = 0;
+        virtual bool getWindowVisible() = 0;
+        virtual bool getWindowFocus() = 0;
+        virtual ActionEnum getKey(KeyEnum key) = 0;
+        virtual glm::dvec2 getMousePosition() = 0;
+        virtual bool getMouseHover() = 0;
+        virtual ActionEnum getMouseButton(MouseButtonEnum button) = 0;
+        virtual std::string getClipboardString() = 0;
+
+        virtual void setWindowShouldClose(bool shouldClose) = 0;
+        virtual void setWindowSizeLimits(int minWidth, int minHeight, int maxWidth, int maxHeight) = 0;
+        virtual void setWindowAspectRatio(int numerator, int denominator) = 0;
+        virtual void setWindowTitle(std::string title) = 0;
+        virtual void setWindowVisible(bool visible) = 0;
+        virtual void setClipboardString(std::string text) = 0;
+
+        /// See Context::latchInput(). Does nothing by default.
+        virtual void latchInput() {}
+        /// Moves the events other threads posted into the queues, for runFrame(). A backend whose
+        /// state snapshot comes from another thread takes it here too, so it matches the events.
+        virtual void drainInbox() { Events::drainInbox(); }
+    };
+
+    /// Not owned. Must outlive the last call to a context function.
+    void setImplementation(ContextI* implementation);
+
+    /// Posts the events of one frame which took @p delta seconds, then polls them: the fixed
+    /// TickEvents which are due (at most g_maxTicksPerFrame) and one UpdateEvent. Every
+    /// implementation's run() calls this once per frame, so they all step the simulation the same.
+    void runFrame(double delta);
+
+    /// Seconds until the next TickEvent is due. How long run() may wait for input.
+    double getTimeUntilNextTick();
+
+    enum struct RedrawMode {
+        Continuous,     // draw every frame
+        OnDemand,       // draw only frames with input / window events or after requestRedraw(). For tools.
+    };
+    void setRedrawMode(RedrawMode mode);
+    RedrawMode getRedrawMode();
+
+    /// Marks the scene dirty, so the next frame is drawn in OnDemand mode. Safe to call from any thread.
+    void requestRedraw();
+
+    /// Whether the frame being dispatched is drawn and presented. Never while iconified. Render
+    /// subscribers skip their work when false, and so must code which draws ImGui windows.
+    bool shouldDraw();
+
+    /// Set by RenderBase::init() to render on the main thread: @p renderFrame renders the newest
+    /// frame the engine submitted, waiting for it at most g_renderThreadWait ms. run() then keeps the
+    /// main thread for the window and calls renderFrame() in a loop, while the engine (events,
+    /// systems, draw call submission) runs on its own thread.
+    void setRenderThread(Functor<void()>&& renderFrame);
+    bool hasRenderThread();
+    void renderFrame();
+
+    /// True while the window is iconified or unfocused. run() then only runs g_backgroundFrameRate
+    /// frames per second. Ticks keep their fixed rate, several are posted per frame.
+    bool isThrottled();
+
+    /// Polls input about g_inputPollRate times per second while run() waits for the next frame,
+    /// instead of once per frame, so input events arrive spread over the frame with their m_time.
+    /// Every MousePositionEvent is kept (CoalescePolicy::None) while it's on. Only with a FramePacer
+    /// target frame rate. In render thread mode the main thread polls between rendered frames anyway.
+    void setHighFrequencyInput(bool enabled);
+    bool getHighFrequencyInput();
+
+    /// Re-samples the mouse (and in render thread mode the keys and buttons) right before draw calls
+    /// are submitted, so getMousePosition() etc. are newer than the events dispatched at the start of
+    /// the frame. Doesn't dispatch anything. Called by RenderMeshComponents when an entity has a
+    /// LateLatch component.
+    void latchInput();
+
+    // forwarded to the implementation:
 
     int run();
     void* getNativeWindowHandle();
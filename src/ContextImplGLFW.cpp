@@ -1,6 +1,8 @@
 #include "Core.hpp"
 
 #include "ContextImplGLFW.hpp"
+#include "FramePacer.hpp"
+#include "Recorder.hpp"
 
 #if defined(__APPLE__)
 #   include "NativeWindowHack.hpp"
@@ -8,6 +10,14 @@
 
 #include <glm/vec2.hpp>
 
+#include <algorithm>  // for std::min
+#include <bitset>
+#include <atomic>
+#include <chrono>   // for std::chrono::duration
+#include <future>   // for std::packaged_task
+#include <mutex>
+#include <thread>
+
 /** logger defines */
 #define BIGG_GLFW_LOG_TRACE(...) SPDLOG_LOGGER_TRACE(Log::m_contextLogger, __VA_ARGS__)
 #define BIGG_GLFW_LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(Log::m_contextLogger, __VA_ARGS__)
@@ -25,88 +35,278 @@ namespace {
     //TODO this should be an array of size MAX_WINDOWS
     GLFWwindow *window = nullptr;
 
-    bool handleWindowCreation(WindowCreateEvent event) {
+    /// Input and window state, kept up to date by the GLFW callbacks, so the getters are memory
+    /// reads instead of GLFW calls.
+    struct WindowState {
+        bool m_exists = false;
+        bool m_shouldClose = false;
+        bool m_iconified = false;
+        bool m_maximized = false;
+        bool m_visible = false;
+        bool m_focused = false;
+        bool m_hovered = false;
+        glm::ivec2 m_size{0, 0};
+        glm::ivec2 m_framebufferSize{0, 0};
+        glm::vec2 m_contentScale{1.0f, 1.0f};
+        glm::ivec2 m_position{0, 0};
+        glm::dvec2 m_mousePosition{0.0, 0.0};
+        std::bitset<GLFW_KEY_LAST + 1> m_keys;                  // set while pressed
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> m_mouseButtons;
+    };
+    WindowState mainState;      // main thread only
+
+    // ------------ render thread mode (see Context::setRenderThread) ---------------
+    // The main thread owns the window and renders, the engine thread runs everything else. GLFW
+    // may only be used on the main thread, so the engine thread reads a copy of mainState the main
+    // thread publishes every iteration, and hands window changes back as commands.
+
+    bool renderThread = false;      // only changes while there is no engine thread
+    std::thread::id mainThreadId;
+    std::atomic<bool> engineDone{false};
+
+    WindowState sharedState;    // guarded by stateMutex
+    WindowState engineState;    // engine thread only
+    std::mutex stateMutex;
+
+    std::vector<Functor<void()>> commands;  // guarded by commandMutex
+    std::mutex commandMutex;
+
+    /// What the getters read.
+    const WindowState& getState() {
+        return renderThread ? engineState : mainState;
+    }
+
+    /// Main thread. Reads all of mainState from GLFW, when the window is created or destroyed.
+    void queryWindowState() {
+        mainState = WindowState{};
+        mainState.m_exists = window != nullptr;
+        if (window != nullptr) {
+            mainState.m_shouldClose = glfwWindowShouldClose(window);
+            mainState.m_iconified = glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+            mainState.m_maximized = glfwGetWindowAttrib(window, GLFW_MAXIMIZED);
+            mainState.m_visible = glfwGetWindowAttrib(window, GLFW_VISIBLE);
+            mainState.m_focused = glfwGetWindowAttrib(window, GLFW_FOCUSED);
+            mainState.m_hovered = glfwGetWindowAttrib(window, GLFW_HOVERED);
+            glfwGetWindowSize(window, &mainState.m_size.x, &mainState.m_size.y);
+            glfwGetFramebufferSize(window, &mainState.m_framebufferSize.x, &mainState.m_framebufferSize.y);
+            glfwGetWindowContentScale(window, &mainState.m_contentScale.x, &mainState.m_contentScale.y);
+            glfwGetWindowPos(window, &mainState.m_position.x, &mainState.m_position.y);
+            glfwGetCursorPos(window, &mainState.m_mousePosition.x, &mainState.m_mousePosition.y);
+        }
+    }
+
+    /// Main thread. Hands mainState to the engine thread.
+    void publishWindowState() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        sharedState = mainState;
+    }
+
+    /// Engine thread. Takes the newest published state, before the first frame.
+    void copyWindowState() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        engineState = sharedState;
+    }
+
+    /// True if the window was focused, unfocused, iconified or restored since @p before, or should
+    /// close. Other input doesn't end a throttled wait early.
+    bool throttleChanged(const WindowState& before, const WindowState& now) {
+        return now.m_focused != before.m_focused || now.m_iconified != before.m_iconified || now.m_shouldClose;
+    }
+
+    /// Runs @p func on the main thread: right away if this is it, otherwise in its next iteration.
+    template<typename Func>
+    void runOnMainThread(Func&& func) {
+        if (!renderThread || std::this_thread::get_id() == mainThreadId) {
+            func();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(commandMutex);
+            commands.emplace_back(std::forward<Func>(func));
+        }
+        glfwPostEmptyEvent();
+    }
+
+    /// Like runOnMainThread, but waits for @p func and returns its result.
+    template<typename Func>
+    auto callOnMainThread(Func&& func) -> decltype(func()) {
+        if (!renderThread || std::this_thread::get_id() == mainThreadId) {
+            return func();
+        }
+        std::packaged_task<decltype(func())()> task(std::forward<Func>(func));
+        auto result = task.get_future();
+        runOnMainThread([&task]() { task(); });
+        return result.get();
+    }
+
+    /// Main thread.
+    void runCommands() {
+        std::vector<Functor<void()>> pending;
+        {
+            std::lock_guard<std::mutex> lock(commandMutex);
+            pending.swap(commands);
+        }
+        for (Functor<void()>& command : pending) {
+            command();
+        }
+    }
+
+    /// Main thread. Posts @p event to the engine thread's inbox together with the state it changed,
+    /// so Impl::drainInbox() never dispatches an event with an older snapshot than the event.
+    template<typename Event>
+    void postWithState(Event&& event) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        sharedState = mainState;
+        Events::postEvent<Event>(std::move(event));
+    }
+
+    /// Called by the GLFW callbacks. The engine thread dispatches events, so with a render thread
+    /// they go through its inbox, and Recorder records them when the engine thread drains it.
+    template<typename Event>
+    void post(Event&& event) {
+        if (renderThread) {
+            postWithState<Event>(std::move(event));
+        } else {
+            Recorder::setEvent<Event>(std::move(event));
+        }
+    }
+
+    /// Same as post(), but dispatched immediately when single threaded.
+    template<typename Event>
+    void postNow(Event&& event) {
+        if (renderThread) {
+            postWithState<Event>(std::move(event));
+        } else {
+            Recorder::setEvent<Event>(std::move(event));
+            Events::pollEvent<Event>();
+        }
+    }
+
+    struct Impl final : Context::ContextI {
+        int run() override;
+        void* getNativeWindowHandle() override;
+        void* getNativeDisplayHandle() override;
+
+        glm::ivec2 getWindowSize() override;
+        glm::ivec2 getWindowFramebufferSize() override;
+        glm::vec2 getWindowContentScale() override;
+        glm::ivec2 getWindowPosition() override;
+        bool getWindowIconified() override;
+        bool getWindowMaximized() override;
+        bool getWindowVisible() override;
+        bool getWindowFocus() override;
+        ActionEnum getKey(KeyEnum key) override;
+        glm::dvec2 getMousePosition() override;
+        bool getMouseHover() override;
+        ActionEnum getMouseButton(MouseButtonEnum button) override;
+        std::string getClipboardString() override;
+
+        void setWindowShouldClose(bool shouldClose) override;
+        void setWindowSizeLimits(int minWidth, int minHeight, int maxWidth, int maxHeight) override;
+        void setWindowAspectRatio(int numerator, int denominator) override;
+        void setWindowTitle(std::string title) override;
+        void setWindowVisible(bool visible) override;
+        void setClipboardString(std::string text) override;
+
+        void latchInput() override;
+        void drainInbox() override;
+    };
+    Impl impl;
+
+    /// Main thread.
+    void createWindow(const WindowCreateEvent& event) {
         BIGG_PROFILE_GLFW_FUNCTION;
         // create glfw window
         if (window != nullptr) {
             BIGG_GLFW_LOG_WARN("Tried to create a window when one already exists!");
-            return false;
+            return;
         }
 
         window = glfwCreateWindow(event.m_size.x, event.m_size.y, event.m_title.c_str(), nullptr, nullptr);
         if (window == nullptr) {
 
             BIGG_GLFW_LOG_WARN("Failed to create a window!");
-            return false;
+            return;
         }
 
         glfwSetWindowCloseCallback(window, [](GLFWwindow *window) {
-            Events::setEvent<WindowShouldCloseEvent>(WindowShouldCloseEvent{});
+            mainState.m_shouldClose = true;
+            post<WindowShouldCloseEvent>(WindowShouldCloseEvent{});
         });
         glfwSetWindowSizeCallback(window, [](GLFWwindow *window, int width, int height) {
-            Events::setEvent<WindowSizeEvent>(WindowSizeEvent{{width, height}});
-            Events::pollEvent<WindowSizeEvent>(); // propogate the event immediately
+            mainState.m_size = {width, height};
+            // coalesced with CoalescePolicy::Latest, so a drag-resize costs one bgfx::reset per frame.
+            post<WindowSizeEvent>(WindowSizeEvent{{width, height}});
         });
         glfwSetFramebufferSizeCallback(window, [](GLFWwindow *window, int width, int height) {
-            Events::setEvent<WindowFramebufferSizeEvent>(WindowFramebufferSizeEvent{{width, height}});
+            mainState.m_framebufferSize = {width, height};
+            post<WindowFramebufferSizeEvent>(WindowFramebufferSizeEvent{{width, height}});
         });
         glfwSetWindowContentScaleCallback(window, [](GLFWwindow *window, float xScale, float yScale) {
-            Events::setEvent<WindowContentScaleEvent>(WindowContentScaleEvent{{xScale, yScale}});
+            mainState.m_contentScale = {xScale, yScale};
+            post<WindowContentScaleEvent>(WindowContentScaleEvent{{xScale, yScale}});
         });
         glfwSetWindowPosCallback(window, [](GLFWwindow *window, int x, int y) {
-            Events::setEvent<WindowPositionEvent>(WindowPositionEvent{{x, y}});
-            Events::pollEvent<WindowPositionEvent>(); // propogate the event immediately
+            mainState.m_position = {x, y};
+            postNow<WindowPositionEvent>(WindowPositionEvent{{x, y}}); // propogate the event immediately
         });
         glfwSetWindowIconifyCallback(window, [](GLFWwindow *window, int iconified) {
-            Events::setEvent<WindowIconifyEvent>(WindowIconifyEvent{static_cast<bool>(iconified)});
-            Events::pollEvent<WindowIconifyEvent>(); // propogate the event immediately
+            mainState.m_iconified = iconified;
+            postNow<WindowIconifyEvent>(WindowIconifyEvent{static_cast<bool>(iconified)}); // propogate the event immediately
         });
         glfwSetWindowMaximizeCallback(window, [](GLFWwindow *window, int maximized) {
-            Events::setEvent<WindowMaximizeEvent>({static_cast<bool>(maximized)});
-            Events::pollEvent<WindowMaximizeEvent>(); // propogate the event immediately
+            mainState.m_maximized = maximized;
+            postNow<WindowMaximizeEvent>({static_cast<bool>(maximized)}); // propogate the event immediately
         });
         glfwSetWindowFocusCallback(window, [](GLFWwindow *window, int focus) {
-            Events::setEvent<WindowFocusEvent>({static_cast<bool>(focus)});
-            Events::pollEvent<WindowFocusEvent>(); // propogate the event immediately
+            mainState.m_focused = focus;
+            postNow<WindowFocusEvent>({static_cast<bool>(focus)}); // propogate the event immediately
         });
         glfwSetWindowRefreshCallback(window, [](GLFWwindow *window) {
-            Events::setEvent<WindowRefreshEvent>({});
+            post<WindowRefreshEvent>({});
         });
         // key callbacks
         glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int scancode, int action, int mods) {
-            Events::setEvent<KeyEvent>({
-                                               static_cast<KeyEnum>(key), scancode, static_cast<ActionEnum>(action),
-                                               static_cast<ModsEnum>(mods)
-                                       });
+            if (key != GLFW_KEY_UNKNOWN) {
+                mainState.m_keys[key] = action != GLFW_RELEASE;
+            }
+            post<KeyEvent>({
+                                                 static_cast<KeyEnum>(key), scancode, static_cast<ActionEnum>(action),
+                                                 static_cast<ModsEnum>(mods), Profile::now()
+                                         });
         });
         glfwSetCharCallback(window, [](GLFWwindow *window, unsigned int codepoint) {
-            Events::setEvent<CharEvent>({codepoint});
+            post<CharEvent>({codepoint, Profile::now()});
         });
         // mouse callbacks
         glfwSetCursorPosCallback(window, [](GLFWwindow *window, double x, double y) {
-            static glm::dvec2 lastMousePos;
+            // not mainState.m_mousePosition, latchInput() moves that between callbacks.
+            static glm::dvec2 lastMousePos = mainState.m_mousePosition;
             glm::dvec2 currentMousePos(x, y);
-
-            Events::setEvent<MousePositionEvent>({
-                                                         currentMousePos,
-                                                         currentMousePos - lastMousePos
-                                                 });
-
-            lastMousePos.x = x;
-            lastMousePos.y = y;
+            mainState.m_mousePosition = currentMousePos;
+
+            post<MousePositionEvent>({
+                                                           currentMousePos,
+                                                           currentMousePos - lastMousePos,
+                                                           Profile::now()
+                                                   });
+            lastMousePos = currentMousePos;
         });
         glfwSetCursorEnterCallback(window, [](GLFWwindow *window, int entered) {
-            Events::setEvent<MouseEnterEvent>({static_cast<bool>(entered)});
+            mainState.m_hovered = entered;
+            post<MouseEnterEvent>({static_cast<bool>(entered)});
         });
         glfwSetMouseButtonCallback(window, [](GLFWwindow *window, int button, int action, int mods) {
-            Events::setEvent<MouseButtonEvent>({
-                                                       static_cast<MouseButtonEnum>(button),
-                                                       static_cast<ActionEnum>(action), static_cast<ModsEnum>(mods)
-                                               });
+            mainState.m_mouseButtons[button] = action != GLFW_RELEASE;
+            post<MouseButtonEvent>({
+                                                         static_cast<MouseButtonEnum>(button),
+                                                         static_cast<ActionEnum>(action), static_cast<ModsEnum>(mods),
+                                                         Profile::now()
+                                                 });
         });
         // scroll callback
         glfwSetScrollCallback(window, [](GLFWwindow *window, double xOffset, double yOffset) {
-            Events::setEvent<ScrollEvent>({{xOffset, yOffset}});
+            post<ScrollEvent>({{xOffset, yOffset}, Profile::now()});
         });
         // drop paths callback
         glfwSetDropCallback(window, [](GLFWwindow *window, int count, const char **paths) {
@@ -115,90 +315,146 @@ namespace {
             for (int i = 0; i < count; i++) {
                 vec.emplace_back(paths[i]);
             }
-            Events::setEvent<DropPathEvent>({vec});
+            post<DropPathEvent>({vec});
         });
-        // post window size event
+        queryWindowState();
+        // the engine thread continues once this returns, and must see the window.
+        if (renderThread) {
+            publishWindowState();
+        }
+    }
+
+    bool handleWindowCreation(const WindowCreateEvent& event) {
+        callOnMainThread([&event]() { createWindow(event); });
         return false;
     }
 
-    bool handleWindowDestruction(WindowDestroyEvent event) {
+    bool handleWindowDestruction(const WindowDestroyEvent& event) {
         BIGG_PROFILE_GLFW_FUNCTION;
-        // destroy window
-        glfwDestroyWindow(window);
-
-        // Rationale: we check if window == nullptr in createWindow so must reset it.
-        window = nullptr;
+        callOnMainThread([]() {
+            // destroy window
+            glfwDestroyWindow(window);
+
+            // Rationale: we check if window == nullptr in createWindow so must reset it.
+            window = nullptr;
+            queryWindowState();
+            if (renderThread) {
+                publishWindowState();
+            }
+        });
         return false;
     }
 
-    bool handleWindowSize(WindowSizeEvent event) {
+    bool handleWindowSize(const WindowSizeEvent& event) {
         if (Context::getWindowSize() == event.m_size) {
             // window size physically changed. No need to do anything.
             return false;   // didn't handle this event
         }
         // else, window size changed programmatically. Need to resize window.
-        glfwSetWindowSize(window, event.m_size.x, event.m_size.y);
+        runOnMainThread([size = event.m_size]() { glfwSetWindowSize(window, size.x, size.y); });
         return true;    // handled this event.
     }
 
-    bool handleWindowPosition(WindowPositionEvent event) {
+    bool handleWindowPosition(const WindowPositionEvent& event) {
         if (Context::getWindowPosition() == event.m_position) {
             // window position physically changed. No need to do anything.
             return false;   // didn't handle this event
         }
         // else, window size changed programmatically. Need to resize window.
-        glfwSetWindowPos(window, event.m_position.x, event.m_position.y);
+        runOnMainThread([position = event.m_position]() { glfwSetWindowPos(window, position.x, position.y); });
         return true;    // handled this event.
     }
 
-    bool handleWindowIconify(WindowIconifyEvent event) {
+    bool handleWindowIconify(const WindowIconifyEvent& event) {
         if (Context::getWindowIconified() == event.m_iconified) {
             // window iconified physically. No need to handle anything.
             return false;
         }
         // else, window iconified programmatically. Need to iconify window.
-        if (event.m_iconified) {
-            glfwIconifyWindow(window);
-        } else {
-            glfwRestoreWindow(window);
-        }
+        runOnMainThread([iconify = event.m_iconified]() {
+            if (iconify) {
+                glfwIconifyWindow(window);
+            } else {
+                glfwRestoreWindow(window);
+            }
+        });
         return true;    // handled this event.
     }
 
-    bool handleWindowMaximize(WindowMaximizeEvent event) {
+    bool handleWindowMaximize(const WindowMaximizeEvent& event) {
         if (Context::getWindowMaximized() == event.m_maximized) {
             // window iconified physically. No need to handle anything.
             return false;
         }
         // else, window iconified programmatically. Need to iconify window.
-        if (event.m_maximized) {
-            glfwMaximizeWindow(window);
-        } else {
-            glfwRestoreWindow(window);
-        }
+        runOnMainThread([maximize = event.m_maximized]() {
+            if (maximize) {
+                glfwMaximizeWindow(window);
+            } else {
+                glfwRestoreWindow(window);
+            }
+        });
         return true;    // handled this event.
     }
 
-    bool handleWindowFocus(WindowFocusEvent event) {
+    bool handleWindowFocus(const WindowFocusEvent& event) {
         if (Context::getWindowFocus() == event.m_focused) {
             // window iconified physically. No need to handle anything.
             return false;
         }
         // else, window iconified programmatically. Need to iconify window.
         if (event.m_focused) {
-            glfwFocusWindow(window);
+            runOnMainThread([]() { glfwFocusWindow(window); });
         } else {
             // there's no way to un-focus a window
         }
         return true;    // handled this event.
     }
 
+    /// The engine loop of the render thread mode. Same as the single threaded one in run(), but
+    /// sleeps instead of waiting for GLFW events.
+    void runEngineThread() {
+        BIGG_PROFILE_THREAD_NAME("Engine");
+        Events::pollEvent<WindowCreateEvent>();
+        copyWindowState();
+        if (!engineState.m_exists) {
+            BIGG_GLFW_LOG_WARN("The context has no windows! Try submitting a WindowCreateEvent");
+        }
+
+        double lastUpdateTime, now;
+        lastUpdateTime = now = Profile::now();
+        while (engineState.m_exists && !engineState.m_shouldClose) {
+            if (Context::isThrottled()) {
+                // at most g_backgroundFrameRate frames, checking every g_backgroundWakeInterval if the window came back.
+                const double nextFrame = lastUpdateTime + 1.0 / g_backgroundFrameRate;
+                while ((now = Profile::now()) < nextFrame) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(std::min(nextFrame - now, g_backgroundWakeInterval)));
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (throttleChanged(engineState, sharedState)) break;
+                }
+                now = Profile::now();
+            } else {
+                if (FramePacer::getTargetFrameRate() == 0.0) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(Context::getTimeUntilNextTick()));
+                }
+                now = FramePacer::waitForNextFrame();
+            }
+
+            // bgfx::frame() at the end of this frame hands its draw calls to the render thread and
+            // returns once the previous frame was rendered, so the two overlap.
+            Context::runFrame(now - lastUpdateTime);
+            lastUpdateTime = now;
+        }
+        engineDone = true;
+    }
+
 }   // anonymous namespace
 
 
     void init() {
         // Since contextLogger is already setup, and I just want to change its name, use spdlog::logger::clone()
         Log::m_contextLogger = Log::m_contextLogger->clone("GLFW");
+        Context::setImplementation(&impl);
 
         Events::subscribe<WindowCreateEvent>(g_contextPriority, handleWindowCreation);
         Events::subscribe<WindowDestroyEvent>(g_contextPriority, handleWindowDestruction);
@@ -210,7 +466,7 @@ namespace {
     }
 }   // namespace GLFWContext
 
-    int ::BIGGEngine::Context::run() {
+    int GLFWContext::Impl::run() {
         {
             BIGG_PROFILE_GLFW_SCOPE("glfwInit()");
             BIGG_GLFW_LOG_DEBUG("Running GLFWContext...");
@@ -224,6 +480,34 @@ namespace {
         }
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);   // important so that window doesn't go black as soon as I move it
         // glfwSwapInterval(1);    //enable vsync
+
+        if (Context::hasRenderThread()) {
+            // this thread keeps the window and renders, everything else runs on the engine thread.
+            renderThread = true;
+            mainThreadId = std::this_thread::get_id();
+            BIGG_PROFILE_THREAD_NAME("Main (window, render)");
+            engineDone = false;
+            publishWindowState();
+            std::thread engine(runEngineThread);
+            while (!engineDone) {
+                {
+                    BIGG_PROFILE_GLFW_SCOPE("glfwPollEvents()");
+                    glfwPollEvents();
+                }
+                runCommands();
+                publishWindowState();
+                Context::renderFrame();    // waits a little for the engine thread's next frame
+            }
+            engine.join();
+            runCommands();
+            renderThread = false;
+
+            BIGG_GLFW_LOG_DEBUG("Terminating GLFWContext...");
+            glfwTerminate();
+            return EXIT_SUCCESS;
+        }
+
+        BIGG_PROFILE_THREAD_NAME("Main");
         // poll events once to see if need to create a window
         Events::pollEvent<WindowCreateEvent>();
         // At this point, the only callback which is subscribed should be
@@ -233,35 +517,46 @@ namespace {
             BIGG_GLFW_LOG_WARN("The context has no windows! Try submitting a WindowCreateEvent");
         }
 
-        // The way this loop ends up working is that its bottlenecked by how
-        // quickly GLFW can poll for events. On my system, mouse events occur
-        // every ~8ms or ~11ms with a bluetooth mouse so that is the most rapidly
-        // the game will recieve update events. If the mouse isn't moving, the game
-        // will recieve an update event every tick, since the world changes at this
-        // rate.
-        double lastUpdateTime, lastTickTime, timeoutTime, now;
-        lastUpdateTime = lastTickTime = now = Profile::now();
+        // With a target frame rate, FramePacer starts frames at that rate and input is only
+        // polled. Otherwise the loop is bottlenecked by how quickly GLFW receives events: mouse
+        // events occur every ~8ms or ~11ms, and without input there is one frame per tick.
+        // The fixed ticks are posted by Context::runFrame().
+        double lastUpdateTime, timeout, now;
+        lastUpdateTime = now = Profile::now();
         while (GLFWContext::window != nullptr && !glfwWindowShouldClose(GLFWContext::window)) {
-            {
-                BIGG_PROFILE_GLFW_SCOPE("glfwWaitEventsTimeout({:.3f})", g_tickDeltaTime);
-                // poll glfw events (which will populate context event queue)
-                glfwWaitEventsTimeout(g_tickDeltaTime);    // at least once per tick
+            if (Context::isThrottled()) {
+                // iconified or in the background: at most g_backgroundFrameRate frames, however much input
+                // arrives. Focusing or restoring the window still wakes up right away.
+                const double nextFrame = lastUpdateTime + 1.0 / g_backgroundFrameRate;
+                const WindowState before = mainState;
+                BIGG_PROFILE_GLFW_SCOPE("glfwWaitEventsTimeout({:.3f})", nextFrame - lastUpdateTime);
+                while ((now = Profile::now()) < nextFrame && !throttleChanged(before, mainState)) {
+                    glfwWaitEventsTimeout(nextFrame - now);
+                }
+                now = Profile::now();
+            } else if (FramePacer::getTargetFrameRate() > 0.0) {
+                if (Context::getHighFrequencyInput()) {
+                    now = FramePacer::waitForNextFrame([]() {
+                        BIGG_PROFILE_GLFW_SCOPE("glfwPollEvents()");
+                        glfwPollEvents();
+                    });
+                } else {
+                    now = FramePacer::waitForNextFrame();
+                }
+                BIGG_PROFILE_GLFW_SCOPE("glfwPollEvents()");
+                glfwPollEvents();
+            } else {
+                timeout = Context::getTimeUntilNextTick();
+                {
+                    BIGG_PROFILE_GLFW_SCOPE("glfwWaitEventsTimeout({:.3f})", timeout);
+                    // poll glfw events (which will populate context event queue)
+                    glfwWaitEventsTimeout(timeout);
+                }
+                now = FramePacer::waitForNextFrame();   // returns immediately, only records the frame time
             }
 
-            now = Profile::now();
-
-            // post an update event
-            Events::setEvent<UpdateEvent>(UpdateEvent{now - lastUpdateTime});
+            Context::runFrame(now - lastUpdateTime);
             lastUpdateTime = now;
-
-                // post a tick event
-            if (now - lastTickTime >= g_tickDeltaTime) {
-                Events::setEvent<TickEvent>(TickEvent{now - lastTickTime});
-                lastTickTime = now;
-            }
-
-                // poll context events
-            Events::pollEvents();
         }
         // post a destroy event
 
@@ -273,21 +568,24 @@ namespace {
 
 
 // getters
-        void *Context::getNativeWindowHandle() {
+        void *GLFWContext::Impl::getNativeWindowHandle() {
+            // the window (and Cocoa) may only be touched on the main thread
+            return callOnMainThread([]() -> void* {
 #   if defined(__APPLE__)
-            BIGG_GLFW_LOG_TRACE("Adding metal layer to cocoa window!");
-            void *out = glfwGetCocoaWindow(GLFWContext::window);
-            BIGG_ASSERT(out != nullptr, "glfwGetCocoaWindow is nullptr!");
-            return addMetalLayerToCocoaWindow(glfwGetCocoaWindow(GLFWContext::window));
+                BIGG_GLFW_LOG_TRACE("Adding metal layer to cocoa window!");
+                void *out = glfwGetCocoaWindow(GLFWContext::window);
+                BIGG_ASSERT(out != nullptr, "glfwGetCocoaWindow is nullptr!");
+                return addMetalLayerToCocoaWindow(glfwGetCocoaWindow(GLFWContext::window));
 #	elif defined(_WIN32)
-            return glfwGetWin32Window(GLFWContext::window);
+                return glfwGetWin32Window(GLFWContext::window);
 #   else
-            BIGG_GLFW_LOG_CRITICAL("cannot get native window for non macos or windows platforms!");
-            return nullptr;
+                BIGG_GLFW_LOG_CRITICAL("cannot get native window for non macos or windows platforms!");
+                return nullptr;
 #	endif // BX_PLATFORM_
+            });
         }
 
-        void *Context::getNativeDisplayHandle() {
+        void *GLFWContext::Impl::getNativeDisplayHandle() {
 #   if defined(__APPLE__) || defined(_WIN32)
             return nullptr;
 #   else
@@ -296,95 +594,127 @@ namespace {
 #   endif
         }
 
-        glm::ivec2 Context::getWindowSize() {
-            int w = 0, h = 0;
-            glfwGetWindowSize(GLFWContext::window, &w, &h);
-            return {w, h};
+        glm::ivec2 GLFWContext::Impl::getWindowSize() {
+            return getState().m_size;
         }
 
-        glm::ivec2 Context::getWindowFramebufferSize() {
-            int w = 0, h = 0;
-            glfwGetFramebufferSize(GLFWContext::window, &w, &h);
-            return {w, h};
+        glm::ivec2 GLFWContext::Impl::getWindowFramebufferSize() {
+            return getState().m_framebufferSize;
         }
 
-        glm::vec2 Context::getWindowContentScale() {
-            float x = 0, y = 0;
-            glfwGetWindowContentScale(GLFWContext::window, &x, &y);
-            return {x, y};
+        glm::vec2 GLFWContext::Impl::getWindowContentScale() {
+            return getState().m_contentScale;
         }
 
-        glm::ivec2 Context::getWindowPosition() {
-            int x = 0, y = 0;
-            glfwGetWindowPos(GLFWContext::window, &x, &y);
-            return {x, y};
+        glm::ivec2 GLFWContext::Impl::getWindowPosition() {
+            return getState().m_position;
         }
 
-        bool Context::getWindowIconified() {
-            return glfwGetWindowAttrib(GLFWContext::window, GLFW_ICONIFIED);
+        bool GLFWContext::Impl::getWindowIconified() {
+            return getState().m_iconified;
         }
 
-        bool Context::getWindowMaximized() {
-            return glfwGetWindowAttrib(GLFWContext::window, GLFW_MAXIMIZED);
+        bool GLFWContext::Impl::getWindowMaximized() {
+            return getState().m_maximized;
         }
 
-        bool Context::getWindowVisible() {
-            return glfwGetWindowAttrib(GLFWContext::window, GLFW_VISIBLE);
+        bool GLFWContext::Impl::getWindowVisible() {
+            return getState().m_visible;
         }
 
-        bool Context::getWindowFocus() {
-            return glfwGetWindowAttrib(GLFWContext::window, GLFW_FOCUSED);
+        bool GLFWContext::Impl::getWindowFocus() {
+            return getState().m_focused;
         }
 
-        ActionEnum Context::getKey(KeyEnum key) {
-            return (ActionEnum)(glfwGetKey(GLFWContext::window, (int) key));
+        ActionEnum GLFWContext::Impl::getKey(KeyEnum key) {
+            const int index = static_cast<int>(key);
+            if (index < 0 || index > GLFW_KEY_LAST) {
+                return ActionEnum::Release;
+            }
+            return getState().m_keys[index] ? ActionEnum::Press : ActionEnum::Release;
         }
 
-        glm::dvec2 Context::getMousePosition() {
-            double x = 0, y = 0;
-            glfwGetCursorPos(GLFWContext::window, &x, &y);
-            return {x, y};
+        glm::dvec2 GLFWContext::Impl::getMousePosition() {
+            return getState().m_mousePosition;
         }
 
-        bool Context::getMouseHover() {
-            return glfwGetWindowAttrib(GLFWContext::window, GLFW_HOVERED);
+        bool GLFWContext::Impl::getMouseHover() {
+            return getState().m_hovered;
         }
 
-        ActionEnum Context::getMouseButton(MouseButtonEnum button) {
-            return (ActionEnum)(glfwGetMouseButton(GLFWContext::window, (int) button));
+        ActionEnum GLFWContext::Impl::getMouseButton(MouseButtonEnum button) {
+            const int index = static_cast<int>(button);
+            if (index < 0 || index > GLFW_MOUSE_BUTTON_LAST) {
+                return ActionEnum::Release;
+            }
+            return getState().m_mouseButtons[index] ? ActionEnum::Press : ActionEnum::Release;
         }
 
-        std::string Context::getClipboardString() {
-            return {glfwGetClipboardString(GLFWContext::window)};
+        std::string GLFWContext::Impl::getClipboardString() {
+            return callOnMainThread([]() { return std::string{glfwGetClipboardString(GLFWContext::window)}; });
         }
 
 // setters
 
-        void Context::setWindowShouldClose(bool shouldClose) {
-            glfwSetWindowShouldClose(GLFWContext::window, shouldClose);
+        void GLFWContext::Impl::setWindowShouldClose(bool shouldClose) {
+            runOnMainThread([shouldClose]() {
+                glfwSetWindowShouldClose(GLFWContext::window, shouldClose);
+                mainState.m_shouldClose = shouldClose;
+            });
         }
 
-        void Context::setWindowSizeLimits(int minWidth, int minHeight, int maxWidth, int maxHeight) {
-            glfwSetWindowSizeLimits(GLFWContext::window, minWidth, minHeight, maxWidth, maxHeight);
+        void GLFWContext::Impl::setWindowSizeLimits(int minWidth, int minHeight, int maxWidth, int maxHeight) {
+            runOnMainThread([=]() { glfwSetWindowSizeLimits(GLFWContext::window, minWidth, minHeight, maxWidth, maxHeight); });
         }
 
-        void Context::setWindowAspectRatio(int numerator, int denominator) {
-            glfwSetWindowAspectRatio(GLFWContext::window, numerator, denominator);
+        void GLFWContext::Impl::setWindowAspectRatio(int numerator, int denominator) {
+            runOnMainThread([=]() { glfwSetWindowAspectRatio(GLFWContext::window, numerator, denominator); });
         }
 
-        void Context::setWindowTitle(std::string title) {
-            glfwSetWindowTitle(GLFWContext::window, title.c_str());
+        void GLFWContext::Impl::setWindowTitle(std::string title) {
+            runOnMainThread([title = std::move(title)]() { glfwSetWindowTitle(GLFWContext::window, title.c_str()); });
         }
 
-        void Context::setWindowVisible(bool visible) {
-            if (visible) {
-                glfwShowWindow(GLFWContext::window);
-            } else {
-                glfwHideWindow(GLFWContext::window);
+        void GLFWContext::Impl::setWindowVisible(bool visible) {
+            runOnMainThread([visible]() {
+                if (visible) {
+                    glfwShowWindow(GLFWContext::window);
+                } else {
+                    glfwHideWindow(GLFWContext::window);
+                }
+                mainState.m_visible = visible;   // GLFW has no callback for it
+            });
+        }
+
+        void GLFWContext::Impl::setClipboardString(std::string text) {
+            runOnMainThread([text = std::move(text)]() { glfwSetClipboardString(NULL, text.c_str()); });
+        }
+
+        void GLFWContext::Impl::latchInput() {
+            BIGG_PROFILE_GLFW_FUNCTION;
+            if (renderThread) {
+                // the main thread publishes every iteration, so this is newer than the frame's copy.
+                std::lock_guard<std::mutex> lock(stateMutex);
+                engineState.m_mousePosition = sharedState.m_mousePosition;
+                engineState.m_hovered = sharedState.m_hovered;
+                engineState.m_keys = sharedState.m_keys;
+                engineState.m_mouseButtons = sharedState.m_mouseButtons;
+            } else if (GLFWContext::window != nullptr) {
+                // asks the OS, no events are processed. Keys and buttons only change with
+                // glfwPollEvents(), which would dispatch events in the middle of the frame.
+                glfwGetCursorPos(GLFWContext::window, &mainState.m_mousePosition.x, &mainState.m_mousePosition.y);
             }
         }
 
-        void Context::setClipboardString(std::string text) {
-            glfwSetClipboardString(NULL, text.c_str());
+        void GLFWContext::Impl::drainInbox() {
+            if (!renderThread) {
+                Events::drainInbox();
+                return;
+            }
+            // The handlers compare events with the state, eg. to tell a physical resize from one
+            // asked for. A snapshot from before the events would make them set the window again.
+            std::lock_guard<std::mutex> lock(stateMutex);
+            Events::drainInbox();
+            engineState = sharedState;
         }
 }  // namespace BIGGEngine
\ No newline at end of file
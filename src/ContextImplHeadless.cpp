@@ -0,0 +1,185 @@
+#include "Core.hpp"
+
+#include "ContextImplHeadless.hpp"
+#include "FramePacer.hpp"
+
+#include <glm/vec2.hpp>
+
+#include <atomic>
+#include <chrono>   // for std::chrono::duration
+#include <thread>
+
+/** logger defines */
+#define BIGG_HEADLESS_LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(Log::m_contextLogger, __VA_ARGS__)
+#define BIGG_HEADLESS_LOG_INFO(...) SPDLOG_LOGGER_INFO(Log::m_contextLogger, __VA_ARGS__)
+#define BIGG_HEADLESS_LOG_WARN(...) SPDLOG_LOGGER_WARN(Log::m_contextLogger, __VA_ARGS__)
+
+#define BIGG_PROFILE_HEADLESS_FUNCTION              _BIGG_PROFILE_CATEGORY_FUNCTION("headless")
+
+namespace BIGGEngine {
+namespace HeadlessContext {
+namespace {
+
+    Settings settings;
+
+    // state of the one (imaginary) window
+    bool windowExists = false;
+    bool shouldClose = false;
+    bool iconified = false;
+    bool maximized = false;
+    bool focused = true;
+    bool visible = true;
+    glm::ivec2 windowSize{0, 0};
+    glm::ivec2 windowPosition{0, 0};
+    std::string windowTitle;
+    std::string clipboard;
+
+    bool handleWindowCreation(const WindowCreateEvent& event) {
+        if (windowExists) {
+            BIGG_HEADLESS_LOG_WARN("Tried to create a window when one already exists!");
+            return false;
+        }
+        windowExists = true;
+        windowSize = event.m_size;
+        windowTitle = event.m_title;
+        return false;
+    }
+
+    bool handleWindowDestruction(const WindowDestroyEvent&) {
+        windowExists = false;
+        shouldClose = true;     // like ContextImplGLFW, run() ends with the window
+        return false;
+    }
+
+    bool handleWindowShouldClose(const WindowShouldCloseEvent&) {
+        shouldClose = true;
+        return false;
+    }
+
+    bool handleWindowSize(const WindowSizeEvent& event) {
+        windowSize = event.m_size;
+        return false;
+    }
+
+    bool handleWindowPosition(const WindowPositionEvent& event) {
+        windowPosition = event.m_position;
+        return false;
+    }
+
+    bool handleWindowIconify(const WindowIconifyEvent& event) {
+        iconified = event.m_iconified;
+        return false;
+    }
+
+    bool handleWindowMaximize(const WindowMaximizeEvent& event) {
+        maximized = event.m_maximized;
+        return false;
+    }
+
+    bool handleWindowFocus(const WindowFocusEvent& event) {
+        focused = event.m_focused;
+        return false;
+    }
+
+    std::atomic<bool> engineDone{false};
+
+    /// Runs the frames. On the engine thread if there is a render thread.
+    void runEngine() {
+        BIGG_PROFILE_THREAD_NAME(Context::hasRenderThread() ? "Engine" : "Main");
+        Events::pollEvent<WindowCreateEvent>();
+
+        uint32_t frame = 0;
+        double lastUpdateTime = Profile::now();
+        while (!shouldClose && (settings.m_frameCount == 0 || frame < settings.m_frameCount)) {
+            if (settings.m_frameDelta > 0.0) {
+                // as fast as possible, but every frame simulates the same time.
+                Context::runFrame(settings.m_frameDelta);
+            } else {
+                double now;
+                if (Context::isThrottled()) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(1.0 / g_backgroundFrameRate));
+                    now = Profile::now();
+                } else {
+                    if (FramePacer::getTargetFrameRate() == 0.0) {
+                        std::this_thread::sleep_for(std::chrono::duration<double>(Context::getTimeUntilNextTick()));
+                    }
+                    now = FramePacer::waitForNextFrame();
+                }
+                Context::runFrame(now - lastUpdateTime);
+                lastUpdateTime = now;
+            }
+            frame++;
+        }
+
+        BIGG_HEADLESS_LOG_DEBUG("Terminating HeadlessContext after {:d} frames...", frame);
+        engineDone = true;
+    }
+
+    struct Impl final : Context::ContextI {
+
+        int run() override {
+            BIGG_PROFILE_HEADLESS_FUNCTION;
+            BIGG_HEADLESS_LOG_DEBUG("Running HeadlessContext...");
+
+            if (Context::hasRenderThread()) {
+                // there's no window to keep on this thread, it only renders.
+                engineDone = false;
+                BIGG_PROFILE_THREAD_NAME("Main (render)");
+                std::thread engine(runEngine);
+                while (!engineDone) {
+                    Context::renderFrame();
+                }
+                engine.join();
+            } else {
+                runEngine();
+            }
+            return EXIT_SUCCESS;
+        }
+
+        void* getNativeWindowHandle() override { return nullptr; }
+        void* getNativeDisplayHandle() override { return nullptr; }
+
+        glm::ivec2 getWindowSize() override { return windowSize; }
+        glm::ivec2 getWindowFramebufferSize() override { return windowSize; }
+        glm::vec2 getWindowContentScale() override { return {1.0f, 1.0f}; }
+        glm::ivec2 getWindowPosition() override { return windowPosition; }
+        bool getWindowIconified() override { return iconified; }
+        bool getWindowMaximized() override { return maximized; }
+        bool getWindowVisible() override { return visible; }
+        bool getWindowFocus() override { return focused; }
+        ActionEnum getKey(KeyEnum) override { return ActionEnum::Release; }
+        glm::dvec2 getMousePosition() override { return {0.0, 0.0}; }
+        bool getMouseHover() override { return false; }
+        ActionEnum getMouseButton(MouseButtonEnum) override { return ActionEnum::Release; }
+        std::string getClipboardString() override { return clipboard; }
+
+        void setWindowShouldClose(bool close) override { shouldClose = close; }
+        void setWindowSizeLimits(int, int, int, int) override {}
+        void setWindowAspectRatio(int, int) override {}
+        void setWindowTitle(std::string title) override { windowTitle = std::move(title); }
+        void setWindowVisible(bool show) override { visible = show; }
+        void setClipboardString(std::string text) override { clipboard = std::move(text); }
+    };
+    Impl impl;
+
+}   // anonymous namespace
+
+    void init(const Settings& s) {
+        Log::m_contextLogger = Log::m_contextLogger->clone("Headless");
+        Context::setImplementation(&impl);
+
+        settings = s;
+        windowExists = shouldClose = iconified = maximized = false;
+        focused = visible = true;
+
+        Events::subscribe<WindowCreateEvent>(g_contextPriority, handleWindowCreation);
+        Events::subscribe<WindowDestroyEvent>(g_contextPriority, handleWindowDestruction);
+        Events::subscribe<WindowShouldCloseEvent>(g_contextPriority, handleWindowShouldClose);
+        Events::subscribe<WindowSizeEvent>(g_contextPriority, handleWindowSize);
+        Events::subscribe<WindowPositionEvent>(g_contextPriority, handleWindowPosition);
+        Events::subscribe<WindowIconifyEvent>(g_contextPriority, handleWindowIconify);
+        Events::subscribe<WindowMaximizeEvent>(g_contextPriority, handleWindowMaximize);
+        Events::subscribe<WindowFocusEvent>(g_contextPriority, handleWindowFocus);
+    }
+}   // namespace HeadlessContext
+}   // namespace BIGGEngine
@@ -0,0 +1,20 @@
+#pragma once
+#include "Context.hpp"
+
+#include <stdint.h>
+
+namespace BIGGEngine {
+
+/// Implementation of ContextI without a window or display, for servers, benchmarks and CI.
+/// A window only exists as its state (size, title, ...) and there is no input. Pair it with
+/// RenderBase::init(true), which renders with bgfx's Noop renderer.
+namespace HeadlessContext {
+
+    struct Settings {
+        uint32_t m_frameCount = 0;  // run() returns after this many frames. 0 runs until the window should close.
+        double m_frameDelta = 0.0;  // seconds each frame simulates, without waiting. 0 runs in real time, paced by FramePacer.
+    };
+
+    void init(const Settings& settings = {});
+};
+}   // namespace BIGGEngine
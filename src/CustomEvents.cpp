@@ -0,0 +1,135 @@
+#include "CustomEvents.hpp"
+
+#include "Core.hpp"
+#include "Subscribers.hpp"
+
+#include <cstring>      // for std::memcpy
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace BIGGEngine {
+namespace Events {
+namespace {
+
+    struct CustomEventType {
+        CustomEventId m_id;
+        uint32_t m_index;       // in types
+        uint32_t m_payloadSize;
+        uint32_t m_capacity;
+        std::vector<std::byte> m_pool;          // filled by setCustomEventBytes
+        std::vector<std::byte> m_dispatchPool;  // handed to the subscribers
+        uint32_t m_count = 0;
+        uint32_t m_overflowCount = 0;
+        Subscribers<CustomEventFunctor> m_subscribers;
+    };
+
+    // a deque, so registering a type from a callback doesn't move the one being dispatched.
+    std::deque<CustomEventType> types;
+    std::unordered_map<CustomEventId, uint32_t> typeIndices;
+
+    /// Indices of the types with events, in the order they got their first event.
+    std::vector<uint32_t> pendingTypes;
+    std::vector<uint32_t> dispatchingTypes;
+
+    CustomEventType* findType(CustomEventId id) {
+        auto it = typeIndices.find(id);
+        return it != typeIndices.end() ? &types[it->second] : nullptr;
+    }
+
+    void dispatch(CustomEventType& type) {
+        // swap pools first, so events set by the subscribers go into the next batch.
+        std::swap(type.m_pool, type.m_dispatchPool);
+        CustomEventBatch batch{type.m_id, type.m_dispatchPool.data(), type.m_count, type.m_payloadSize};
+        type.m_count = 0;
+
+        type.m_subscribers.dispatch(batch);
+    }
+
+} // anonymous namespace
+
+    CustomEventId registerCustomEvent(entt::hashed_string name, uint32_t payloadSize, uint32_t capacity) {
+        BIGG_ASSERT(payloadSize > 0 && capacity > 0, "Custom event '{:s}' needs a payload and a capacity!", name.data());
+
+        if(CustomEventType* type = findType(name.value())) {
+            BIGG_ASSERT(type->m_payloadSize == payloadSize, "Custom event '{:s}' was registered with a different payload size!", name.data());
+            return type->m_id;
+        }
+
+        typeIndices.emplace(name.value(), static_cast<uint32_t>(types.size()));
+        CustomEventType& type = types.emplace_back();
+        type.m_id = name.value();
+        type.m_index = static_cast<uint32_t>(types.size() - 1);
+        type.m_payloadSize = payloadSize;
+        type.m_capacity = capacity;
+        type.m_pool.resize(size_t(payloadSize) * capacity);
+        type.m_dispatchPool.resize(size_t(payloadSize) * capacity);
+
+        BIGG_LOG_DEBUG("Registered custom event '{:s}' ({:d} byte payload, capacity {:d}).", name.data(), payloadSize, capacity);
+        return type.m_id;
+    }
+
+    uint32_t getCustomEventPayloadSize(CustomEventId id) {
+        CustomEventType* type = findType(id);
+        return type ? type->m_payloadSize : 0;
+    }
+
+    bool setCustomEventBytes(CustomEventId id, const void* payload) {
+        CustomEventType* type = findType(id);
+        if(!type) {
+            BIGG_LOG_WARN("Custom event {:d} isn't registered!", id);
+            return false;
+        }
+        if(type->m_count == type->m_capacity) {
+            ++type->m_overflowCount;
+            return false;
+        }
+        std::memcpy(type->m_pool.data() + size_t(type->m_count) * type->m_payloadSize, payload, type->m_payloadSize);
+        if(type->m_count++ == 0) {
+            pendingTypes.push_back(type->m_index);
+        }
+        return true;
+    }
+
+    uint32_t getCustomEventOverflowCount(CustomEventId id) {
+        CustomEventType* type = findType(id);
+        return type ? type->m_overflowCount : 0;
+    }
+
+    bool subscribeCustom(CustomEventId id, uint16_t priority, CustomEventFunctor&& functor) {
+        CustomEventType* type = findType(id);
+        if(!type) {
+            BIGG_LOG_WARN("Can't subscribe to custom event {:d}, it isn't registered!", id);
+            return false;
+        }
+        return type->m_subscribers.add(priority, std::move(functor));
+    }
+
+    bool unsubscribeCustom(CustomEventId id, uint16_t priority) {
+        CustomEventType* type = findType(id);
+        if(!type) return false;
+
+        return type->m_subscribers.remove(priority);
+    }
+
+    void pollCustomEvents() {
+        if(pendingTypes.empty()) return;
+        BIGG_PROFILE_RUN_FUNCTION;
+
+        // events set by the subscribers are dispatched on the next poll.
+        std::swap(pendingTypes, dispatchingTypes);
+        for(uint32_t index : dispatchingTypes) {
+            dispatch(types[index]);
+        }
+        dispatchingTypes.clear();
+    }
+
+    void initCustomEvents() {
+        types.clear();
+        typeIndices.clear();
+        pendingTypes.clear();
+        dispatchingTypes.clear();
+    }
+
+} // namespace Events
+} // namespace BIGGEngine
@@ -0,0 +1,85 @@
+//      Event types registered at runtime, for game specific signals (damage, pickups, ...) which
+//      don't belong in FOR_EACH_EVENT. Usable from C++ and from Lua scripts.
+
+// A custom event type is identified by the hash of its name, so its id is the same in every run and
+// in every script. Its payload is a fixed number of bytes. Each type gets two pools of
+// capacity * payloadSize bytes when it is registered: one is filled by setCustomEvent while the
+// other one is being dispatched. Nothing allocates per event.
+
+// Delivery is batched: pollEvents() calls each subscriber of a type once with every payload set
+// since the last poll, in ascending priority order. Returning true consumes the whole batch.
+#pragma once
+
+#include "Config.hpp"
+#include "Functor.hpp"
+#include "Log.hpp"  // for BIGG_ASSERT
+
+#include <entt/core/hashed_string.hpp>
+
+#include <cstddef>      // for std::byte
+#include <stdint.h>
+#include <type_traits>  // for std::is_trivially_copyable_v
+
+namespace BIGGEngine {
+namespace Events {
+
+    using CustomEventId = entt::hashed_string::hash_type;
+
+    /// Every payload set for one custom event type since the last poll, oldest first.
+    struct CustomEventBatch {
+        CustomEventId m_id;
+        const std::byte* m_data;
+        uint32_t m_count;
+        uint32_t m_payloadSize;
+
+        const void* payload(uint32_t index) const { return m_data + index * m_payloadSize; }
+
+        template<typename Payload>
+        const Payload& get(uint32_t index) const {
+            BIGG_ASSERT(sizeof(Payload) == m_payloadSize, "Payload type doesn't match the registered payload size!");
+            return *static_cast<const Payload*>(payload(index));
+        }
+    };
+
+    using CustomEventFunctor = Functor<bool(const CustomEventBatch&)>;
+
+    /// Registers a custom event type with @p payloadSize bytes of payload and room for @p capacity
+    /// events between two polls. Registering a name again returns the same id, the payload size
+    /// must match.
+    CustomEventId registerCustomEvent(entt::hashed_string name, uint32_t payloadSize, uint32_t capacity = g_customEventCapacity);
+
+    template<typename Payload>
+    CustomEventId registerCustomEvent(entt::hashed_string name, uint32_t capacity = g_customEventCapacity) {
+        static_assert(std::is_trivially_copyable_v<Payload>, "Custom event payloads are copied as raw bytes!");
+        return registerCustomEvent(name, sizeof(Payload), capacity);
+    }
+
+    /// 0 if @p id isn't registered.
+    uint32_t getCustomEventPayloadSize(CustomEventId id);
+
+    /// Copies getCustomEventPayloadSize(id) bytes from @p payload into the type's pool. Returns
+    /// false if the type isn't registered or its pool is full. Main thread only, like setEvent.
+    bool setCustomEventBytes(CustomEventId id, const void* payload);
+
+    template<typename Payload>
+    bool setCustomEvent(CustomEventId id, const Payload& payload) {
+        static_assert(std::is_trivially_copyable_v<Payload>, "Custom event payloads are copied as raw bytes!");
+        BIGG_ASSERT(getCustomEventPayloadSize(id) == sizeof(Payload), "Payload type doesn't match the registered payload size!");
+        return setCustomEventBytes(id, &payload);
+    }
+
+    /// Number of events of this type which were dropped because the pool was full.
+    uint32_t getCustomEventOverflowCount(CustomEventId id);
+
+    /// Same rules as subscribe(). Returns false if @p id isn't registered or @p priority is taken.
+    bool subscribeCustom(CustomEventId id, uint16_t priority, CustomEventFunctor&& functor);
+    bool unsubscribeCustom(CustomEventId id, uint16_t priority);
+
+    /// Dispatches every custom event type which has events. Called by pollEvents().
+    void pollCustomEvents();
+
+    /// Unregisters every custom event type. Called by Events::init() and Events::reset().
+    void initCustomEvents();
+
+} // namespace Events
+} // namespace BIGGEngine
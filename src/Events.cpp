@@ -1,80 +1,557 @@
 #include "Events.hpp"
+#include "CustomEvents.hpp"
+#include "Jobs.hpp"
+#include "Timers.hpp"
 
 #include "Log.hpp"
 #include "Debug.hpp"
+#include "Profile.hpp"
+#include "Subscribers.hpp"
+
+#include <bx/uint32_t.h> // for bx::uint64_cnttz
+
+#include <algorithm>    // for std::lower_bound, std::find_if, std::remove_if
+#include <array>
+#include <atomic>
 
 namespace BIGGEngine {
 namespace Events {
 namespace {
 
+    /// Fixed size FIFO of events. All slots are allocated with the queue, so pushing and popping
+    /// events never touches the heap.
+    template<typename Event, uint32_t Capacity>
+    struct EventQueue {
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Event queue capacity must be a power of two!");
+
+        bool push(Event&& e) {
+            if(size() == Capacity) {
+                ++m_overflowCount;
+                return false;
+            }
+            m_events[m_tail & (Capacity - 1)] = std::move(e);
+            ++m_tail;
+            return true;
+        }
+
+        Event& front() { return m_events[m_head & (Capacity - 1)]; }
+        Event& back() { return m_events[(m_tail - 1) & (Capacity - 1)]; }
+        void pop() { ++m_head; }
+
+        uint32_t size() const { return m_tail - m_head; }   // unsigned wrap-around keeps this correct
+        bool empty() const { return m_head == m_tail; }
+
+        /// True if the last queued event can still be merged with, ie. it isn't being dispatched.
+        bool canCoalesce() const { return size() > (m_dispatching ? 1u : 0u); }
+
+        void clear() {
+            m_head = m_tail = 0;
+            m_overflowCount = 0;
+            m_dispatching = false;
+            m_receivedSincePoll = false;
+        }
+
+        std::array<Event, Capacity> m_events;
+        uint32_t m_head = 0;
+        uint32_t m_tail = 0;
+        uint32_t m_overflowCount = 0;
+        bool m_dispatching = false;         // front() is currently being handed to the callbacks
+        bool m_receivedSincePoll = false;   // for CoalescePolicy::Debounce
+    };
+
+    /// Bounded multi-producer single-consumer queue, used as the inbox for events posted from other
+    /// threads. Each slot carries a sequence number which tells producers and the consumer whose
+    /// turn it is (see Dmitry Vyukov's bounded MPMC queue). Producers only contend on m_enqueuePos
+    /// and never block: if the slot they claimed is still full, the inbox is full.
+    template<typename Event, uint32_t Capacity>
+    struct EventInbox {
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Event inbox capacity must be a power of two!");
+
+        EventInbox() { clear(); }
+
+        /// Any thread.
+        bool push(Event&& e) {
+            Slot* slot;
+            uint32_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for(;;) {
+                slot = &m_slots[pos & (Capacity - 1)];
+                int32_t diff = static_cast<int32_t>(slot->m_sequence.load(std::memory_order_acquire) - pos);
+                if(diff == 0) {
+                    // slot is free, try to claim it
+                    if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if(diff < 0) {
+                    // slot still holds an event from the previous lap
+                    m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    // another producer claimed it first
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            slot->m_event = std::move(e);
+            slot->m_sequence.store(pos + 1, std::memory_order_release);    // publish to the consumer
+            return true;
+        }
+
+        /// Consumer thread only.
+        bool pop(Event& out) {
+            Slot& slot = m_slots[m_dequeuePos & (Capacity - 1)];
+            if(slot.m_sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+                return false;   // empty, or the producer hasn't finished writing yet
+            }
+            out = std::move(slot.m_event);
+            slot.m_sequence.store(m_dequeuePos + Capacity, std::memory_order_release);  // free for the next lap
+            ++m_dequeuePos;
+            return true;
+        }
+
+        /// Not thread safe.
+        void clear() {
+            for(uint32_t i = 0; i < Capacity; i++) {
+                m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+                m_slots[i].m_event = Event{};
+            }
+            m_enqueuePos.store(0, std::memory_order_relaxed);
+            m_dequeuePos = 0;
+            m_overflowCount.store(0, std::memory_order_relaxed);
+        }
+
+        struct Slot {
+            std::atomic<uint32_t> m_sequence;
+            Event m_event;
+        };
+
+        std::array<Slot, Capacity> m_slots;
+        alignas(64) std::atomic<uint32_t> m_enqueuePos;     // written by producers
+        alignas(64) uint32_t m_dequeuePos;                  // written by the consumer
+        std::atomic<uint32_t> m_overflowCount;
+    };
+
+#if BIGG_CONFIG_EVENT_STATS
+    bool statsEnabled = false;
+#endif
+
     template<typename Event>
-    std::map<uint16_t, functor_t<Event>> callbacks;
+    struct Observer {
+        uint16_t m_id;
+        observer_t<Event> m_functor;
+    };
+
+    /// Observers of one event type, and a copy of every event they still have to see. The copies
+    /// are needed because the queue slots are reused as soon as an event is popped.
+    template<typename Event>
+    struct Observers {
+
+        bool add(uint16_t id, observer_t<Event>&& functor) {
+            if(find(id) != m_list.end()) return false;
+            m_list.push_back({id, std::move(functor)});
+            if(m_batch.capacity() == 0) m_batch.reserve(queueCapacity<Event>);
+            return true;
+        }
+
+        bool remove(uint16_t id) {
+            auto it = find(id);
+            if(it == m_list.end()) return false;
+            m_list.erase(it);
+            return true;
+        }
+
+        void clear() {
+            m_list.clear();
+            m_batch.clear();
+        }
+
+        std::vector<Observer<Event>> m_list;
+        std::vector<Event> m_batch;
+
+    private:
+        typename std::vector<Observer<Event>>::iterator find(uint16_t id) {
+            return std::find_if(m_list.begin(), m_list.end(), [id](const Observer<Event>& observer) {
+                return observer.m_id == id;
+            });
+        }
+    };
+
+    /// One observer with its whole batch of events.
+    struct ObserverTask {
+        void(*m_function)(uint32_t);
+        uint32_t m_index;
+    };
 
     template<typename Event>
-    Event event;
+    Subscribers<functor_t<Event>> callbacks;
 
     template<typename Event>
-    bool handled;
+    Observers<Event> observers;
+
+    std::vector<ObserverTask> observerTasks;
+
+    /// Bit eventIndex<Event> is set while observers<Event>.m_batch has events. Main thread only.
+    uint64_t observedMask = 0;
+    bool observersRunning = false;
+
+    template<typename Event>
+    EventQueue<Event, queueCapacity<Event>> queue;
+
+    template<typename Event>
+    CoalescePolicy policy;
+
+    static_assert(EventTypes::size < 64, "Too many event types for the pending mask!");
+
+    /// Bit eventIndex<Event> is set while that type has queued events.
+    std::atomic<uint64_t> pending{0};
+
+    template<typename Event>
+    constexpr uint64_t pendingBit = uint64_t(1) << eventIndex<Event>;
+
+    template<typename Event>
+    EventInbox<Event, inboxCapacity<Event>> inbox;
+
+    /// Bit eventIndex<Event> is set once another thread has posted to that type's inbox.
+    std::atomic<uint64_t> inboxPending{0};
+
+    template<typename Event>
+    drain_callback_t<Event> drainCallback = nullptr;
+
+    // How CoalescePolicy::Accumulate merges @p e into the already @p queued event.
+    // By default only the latest state is kept. Overload this for events which carry a delta.
+    template<typename Event>
+    void accumulate(Event& queued, Event&& e) {
+        queued = std::move(e);
+    }
+    void accumulate(MousePositionEvent& queued, MousePositionEvent&& e) {
+        queued.m_mousePosition = e.m_mousePosition;
+        queued.m_delta += e.m_delta;
+        queued.m_time = e.m_time;
+    }
+    void accumulate(ScrollEvent& queued, ScrollEvent&& e) {
+        queued.m_delta += e.m_delta;
+        queued.m_time = e.m_time;
+    }
+
+    void setDefaultCoalescePolicies() {
+#       define SET_POLICY(T, value) policy<T ## Event> = value;
+        FOR_EACH_EVENT(SET_POLICY, CoalescePolicy::None)
+        // these fire hundreds of times per second but subscribers only care about the end result.
+        policy<MousePositionEvent>          = CoalescePolicy::Accumulate;
+        policy<ScrollEvent>                 = CoalescePolicy::Accumulate;
+        policy<WindowSizeEvent>             = CoalescePolicy::Latest;
+        policy<WindowFramebufferSizeEvent>  = CoalescePolicy::Latest;
+    }
 
 } // anonymous namespace
 
     void init() {
-#       define INIT_CALLBACK(T) callbacks<T ## Event> = {};
-#       define INIT_EVENT(T) event<T ## Event> = {};
-#       define SET_HANDLED(T, value) handled<T ## Event> = value;
+#       define INIT_CALLBACK(T) callbacks<T ## Event>.clear();
+#       define CLEAR_QUEUE(T) queue<T ## Event>.clear(); inbox<T ## Event>.clear();
+#       define CLEAR_OBSERVERS(T) observers<T ## Event>.clear();
         FOR_EACH_EVENT(INIT_CALLBACK)
-        FOR_EACH_EVENT(INIT_EVENT)
-        FOR_EACH_EVENT(SET_HANDLED, true)
+        FOR_EACH_EVENT(CLEAR_QUEUE)
+        FOR_EACH_EVENT(CLEAR_OBSERVERS)
+        observedMask = 0;
+        pending.store(0, std::memory_order_relaxed);
+        inboxPending.store(0, std::memory_order_relaxed);
+        setDefaultCoalescePolicies();
+        initCustomEvents();
+        initTimers();
+    }
+
+    template<typename Event>
+    void setCoalescePolicy(CoalescePolicy p) {
+        policy<Event> = p;
+    }
+
+    template<typename Event>
+    CoalescePolicy getCoalescePolicy() {
+        return policy<Event>;
     }
 
     template<typename Event>
     bool subscribe(uint16_t priority, functor_t<Event>&& functor) {
-        if (callbacks<Event>.count(priority)) {
-            return false;
-        }
-        callbacks<Event>[priority] = std::forward<functor_t<Event>>(functor);
-        return true;
+        return callbacks<Event>.add(priority, std::move(functor));
     }
 
     template<typename Event>
     bool unsubscribe(uint16_t priority) {
-        return callbacks<Event>.erase(priority);;
+        return callbacks<Event>.remove(priority);
+    }
+
+    template<typename Event>
+    bool observe(uint16_t id, observer_t<Event>&& observer) {
+        BIGG_ASSERT(!observersRunning, "Can't observe from an observer!");
+        return observers<Event>.add(id, std::move(observer));
+    }
+
+    template<typename Event>
+    bool unobserve(uint16_t id) {
+        BIGG_ASSERT(!observersRunning, "Can't unobserve from an observer!");
+        return observers<Event>.remove(id);
     }
 
     template<typename Event>
     void setEvent(Event&& e) {
-        event<Event> = e;
-        handled<Event> = false;
+        queue<Event>.m_receivedSincePoll = true;
+        pending.fetch_or(pendingBit<Event>, std::memory_order_relaxed);
+
+        if(policy<Event> != CoalescePolicy::None && queue<Event>.canCoalesce()) {
+            if(policy<Event> == CoalescePolicy::Accumulate) {
+                accumulate(queue<Event>.back(), std::move(e));
+            } else {
+                queue<Event>.back() = std::move(e);
+            }
+            return;
+        }
+
+        if(!queue<Event>.push(std::move(e))) {
+            BIGG_LOG_DEBUG("Dropped a {:s} event because its queue is full! ({:d} dropped so far)",
+                           Debug::g_eventTypeDebugStrings.at(Event::m_type), queue<Event>.m_overflowCount);
+        }
+    }
+
+    template<typename Event>
+    uint32_t getOverflowCount() {
+        return queue<Event>.m_overflowCount;
+    }
+
+    template<typename Event>
+    bool postEvent(Event&& e) {
+        if(!inbox<Event>.push(std::move(e))) {
+            return false;   // no logging, the logger isn't necessarily safe to call from here
+        }
+        inboxPending.fetch_or(pendingBit<Event>, std::memory_order_release);
+        return true;
+    }
+
+    template<typename Event>
+    void setDrainCallback(drain_callback_t<Event> callback) {
+        drainCallback<Event> = callback;
+    }
+
+    template<typename Event>
+    uint32_t getInboxOverflowCount() {
+        return inbox<Event>.m_overflowCount.load(std::memory_order_relaxed);
+    }
+
+    void setDispatchStatsEnabled(bool enabled) {
+#if BIGG_CONFIG_EVENT_STATS
+        statsEnabled = enabled;
+#else
+        BX_UNUSED(enabled);
+#endif
+    }
+
+    bool getDispatchStatsEnabled() {
+#if BIGG_CONFIG_EVENT_STATS
+        return statsEnabled;
+#else
+        return false;
+#endif
+    }
+
+    std::vector<SubscriberStats> getDispatchStats() {
+        std::vector<SubscriberStats> out;
+#if BIGG_CONFIG_EVENT_STATS
+#       define APPEND_STATS(T) callbacks<T ## Event>.appendStats(T ## Event::m_type, out);
+        FOR_EACH_EVENT(APPEND_STATS)
+#endif
+        return out;
+    }
+
+    void resetDispatchStats() {
+#if BIGG_CONFIG_EVENT_STATS
+#       define RESET_STATS(T) callbacks<T ## Event>.resetStats();
+        FOR_EACH_EVENT(RESET_STATS)
+#endif
     }
 
     template<typename Event>
     void pollEvent() {
-        if(handled<Event>) return;
-        for(auto& [priority, functor] : callbacks<Event>) {
-            handled<Event> = functor.operator()(event<Event>);
-            if(handled<Event>) break;
+        if(policy<Event> == CoalescePolicy::Debounce && queue<Event>.m_receivedSincePoll) {
+            // still receiving events. Wait until they settle down.
+            queue<Event>.m_receivedSincePoll = false;
+            return;
+        }
+        queue<Event>.m_receivedSincePoll = false;
+
+        // Only drain the events which are queued right now. A callback may post another event of the
+        // same type, which will be dispatched on the next poll instead of looping forever.
+        for(uint32_t count = queue<Event>.size(); count > 0; count--) {
+            // The event stays in its slot and is handed to the subscribers by reference. push()
+            // can't overwrite it since the slot is only released by pop().
+            queue<Event>.m_dispatching = true;
+#if BIGG_CONFIG_EVENT_STATS
+            callbacks<Event>.dispatch(queue<Event>.front(), statsEnabled);
+#else
+            callbacks<Event>.dispatch(queue<Event>.front());
+#endif
+            queue<Event>.m_dispatching = false;
+            if(!observers<Event>.m_list.empty()) {
+                observers<Event>.m_batch.push_back(queue<Event>.front());
+                observedMask |= pendingBit<Event>;
+            }
+            queue<Event>.pop();
+        }
+
+        if(queue<Event>.empty()) {
+            pending.fetch_and(~pendingBit<Event>, std::memory_order_relaxed);
         }
-        handled<Event> = true;
+    }
+
+namespace {
+    using PollFunction = void(*)();
+
+    template<typename Event>
+    void drainInboxOf() {
+        Event e;
+        while(inbox<Event>.pop(e)) {
+            if(drainCallback<Event>) drainCallback<Event>(e);
+            setEvent<Event>(std::move(e));
+        }
+    }
+
+    template<typename Event>
+    void runObserver(uint32_t index) {
+        Observers<Event>& o = observers<Event>;
+        for(const Event& e : o.m_batch) {
+            o.m_list[index].m_functor(e);
+        }
+    }
+
+    template<typename Event>
+    void addObserverTasks() {
+        for(uint32_t i = 0; i < observers<Event>.m_list.size(); i++) {
+            observerTasks.push_back({&runObserver<Event>, i});
+        }
+    }
+
+    template<typename Event>
+    void clearObserverBatch() {
+        observers<Event>.m_batch.clear();
+    }
+
+    template<typename... Ts>
+    constexpr std::array<PollFunction, sizeof...(Ts)> makeAddObserverTasksTable(TypeList<Ts...>) {
+        return {&addObserverTasks<Ts>...};
+    }
+
+    template<typename... Ts>
+    constexpr std::array<PollFunction, sizeof...(Ts)> makeClearObserverBatchTable(TypeList<Ts...>) {
+        return {&clearObserverBatch<Ts>...};
+    }
+
+    template<typename... Ts>
+    constexpr std::array<PollFunction, sizeof...(Ts)> makePollTable(TypeList<Ts...>) {
+        return {&pollEvent<Ts>...};
+    }
+
+    template<typename... Ts>
+    constexpr std::array<PollFunction, sizeof...(Ts)> makeDrainTable(TypeList<Ts...>) {
+        return {&drainInboxOf<Ts>...};
+    }
+
+    // pollEvent<Event> and drainInboxOf<Event> for each type, indexed by eventIndex<Event>.
+    constexpr std::array<PollFunction, EventTypes::size> pollTable = makePollTable(EventTypes{});
+    constexpr std::array<PollFunction, EventTypes::size> drainTable = makeDrainTable(EventTypes{});
+    constexpr std::array<PollFunction, EventTypes::size> addObserverTasksTable = makeAddObserverTasksTable(EventTypes{});
+    constexpr std::array<PollFunction, EventTypes::size> clearObserverBatchTable = makeClearObserverBatchTable(EventTypes{});
+
+    /// Runs every observer over its type's batch, one task per observer, and clears the batches.
+    void runObservers() {
+        BIGG_PROFILE_RUN_FUNCTION;
+        observerTasks.clear();
+        for(uint64_t mask = observedMask; mask != 0; mask &= mask - 1) {
+            addObserverTasksTable[bx::uint64_cnttz(mask)]();
+        }
+
+        observersRunning = true;
+        if(!observerTasks.empty()) {
+            // the first task runs on this thread, which then helps with the rest until all are done.
+            Jobs::Counter counter;
+            for(size_t i = 1; i < observerTasks.size(); i++) {
+                Jobs::run([task = observerTasks[i]]() { task.m_function(task.m_index); }, &counter);
+            }
+            observerTasks[0].m_function(observerTasks[0].m_index);
+            Jobs::wait(counter);
+        }
+        observersRunning = false;
+
+        for(uint64_t mask = observedMask; mask != 0; mask &= mask - 1) {
+            clearObserverBatchTable[bx::uint64_cnttz(mask)]();
+        }
+        observedMask = 0;
+    }
+} // anonymous namespace
+
+    void drainInbox() {
+        // A producer sets its bit after publishing, so an event which is published after the exchange
+        // either gets drained now anyways or sets the bit again for the next drain.
+        uint64_t mask = inboxPending.exchange(0, std::memory_order_acquire);
+        while(mask != 0) {
+            uint32_t index = bx::uint64_cnttz(mask);
+            drainTable[index]();
+            mask &= mask - 1;
+        }
+    }
+
+    uint64_t getPendingMask() {
+        return pending.load(std::memory_order_relaxed);
     }
 
     void pollEvents() {
-#       define POLL_EVENT(T) pollEvent<T ## Event>();
-        FOR_EACH_EVENT(POLL_EVENT)
+        // Visit set bits in ascending order, like the old FOR_EACH_EVENT(POLL_EVENT) did. The mask is
+        // reloaded after each type so events posted by callbacks for a later type still get polled
+        // in this pass.
+        uint32_t index = 0;
+        uint64_t mask;
+        while(index < EventTypes::size && (mask = pending.load(std::memory_order_relaxed) >> index) != 0) {
+            index += bx::uint64_cnttz(mask);
+            pollTable[index]();
+            index++;
+        }
+        pollCustomEvents();
+
+        if(observedMask != 0) {
+            runObservers();
+        }
     }
     void reset() {
 #       define UNSUBSCRIBE_EVENT(T) callbacks<T ## Event>.clear();
-#       define SET_HANDLED(T, value) handled<T ## Event> = value;
         FOR_EACH_EVENT(UNSUBSCRIBE_EVENT)
-        FOR_EACH_EVENT(SET_HANDLED, false)
+        FOR_EACH_EVENT(CLEAR_QUEUE)
+        FOR_EACH_EVENT(CLEAR_OBSERVERS)
+        observedMask = 0;
+        pending.store(0, std::memory_order_relaxed);
+        inboxPending.store(0, std::memory_order_relaxed);
+        setDefaultCoalescePolicies();
+        initCustomEvents();
+        initTimers();
     }
 
     // explicitly state which template specializations should be created.
+#   define EXPLICIT_TEMPLATE_SET_COALESCE_POLICY(T) template void setCoalescePolicy<T ## Event>(CoalescePolicy);
+#   define EXPLICIT_TEMPLATE_GET_COALESCE_POLICY(T) template CoalescePolicy getCoalescePolicy<T ## Event>();
 #   define EXPLICIT_TEMPLATE_SUBSCRIBE(T) template bool subscribe<T ## Event>(uint16_t, functor_t<T ## Event>&&);
 #   define EXPLICIT_TEMPLATE_UNSUBSCRIBE(T) template bool unsubscribe<T ## Event>(uint16_t);
+#   define EXPLICIT_TEMPLATE_OBSERVE(T) template bool observe<T ## Event>(uint16_t, observer_t<T ## Event>&&);
+#   define EXPLICIT_TEMPLATE_UNOBSERVE(T) template bool unobserve<T ## Event>(uint16_t);
 #   define EXPLICIT_TEMPLATE_SET_EVENT(T) template void setEvent<T ## Event>(T ## Event&&);
+#   define EXPLICIT_TEMPLATE_GET_OVERFLOW_COUNT(T) template uint32_t getOverflowCount<T ## Event>();
+#   define EXPLICIT_TEMPLATE_POST_EVENT(T) template bool postEvent<T ## Event>(T ## Event&&);
+#   define EXPLICIT_TEMPLATE_GET_INBOX_OVERFLOW_COUNT(T) template uint32_t getInboxOverflowCount<T ## Event>();
+#   define EXPLICIT_TEMPLATE_SET_DRAIN_CALLBACK(T) template void setDrainCallback<T ## Event>(drain_callback_t<T ## Event>);
+#   define EXPLICIT_TEMPLATE_POLL_EVENT(T) template void pollEvent<T ## Event>();
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_SET_COALESCE_POLICY)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_GET_COALESCE_POLICY)
     FOR_EACH_EVENT(EXPLICIT_TEMPLATE_SUBSCRIBE)
     FOR_EACH_EVENT(EXPLICIT_TEMPLATE_UNSUBSCRIBE)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_OBSERVE)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_UNOBSERVE)
     FOR_EACH_EVENT(EXPLICIT_TEMPLATE_SET_EVENT)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_GET_OVERFLOW_COUNT)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_POST_EVENT)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_GET_INBOX_OVERFLOW_COUNT)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_SET_DRAIN_CALLBACK)
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_POLL_EVENT)
 
 } // namespace Events
 } // namespace BIGGEngine
@@ -1,24 +1,23 @@
 #pragma once
 
+#include "Config.hpp"
 #include "Debug.hpp"
 #include "InputEnums.hpp"
 
-//#include "Functor.hpp"
-#include <functional>
+#include "Functor.hpp"
 
 #include <glm/vec2.hpp>
 
 #include <string>
+#include <type_traits>  // for std::is_same_v
 #include <vector>
-#include <map>
-
-// TODO REPLACE WITH entt::emitter
-// https://github.com/skypjack/entt/blob/master/docs/md/signal.md
 
 template<typename T>
-using functor_t = std::function<bool(T)>;
+using functor_t = BIGGEngine::EventFunctor<T>;
+template<typename T>
+using observer_t = BIGGEngine::ObserverFunctor<T>;
 
-#define ADD_TYPE_MEMBER(_eventType) static inline Events::EventType m_type = Events::EventType::_eventType;
+#define ADD_TYPE_MEMBER(_eventType) static constexpr Events::EventType m_type = Events::EventType::_eventType;
 
 #define FOR_EACH_EVENT(expr, ...) \
     expr(Update, ##__VA_ARGS__)\
@@ -53,25 +52,121 @@ namespace Events {
     enum struct EventType {
 #           define PUT_COMMA(T) T,
         FOR_EACH_EVENT(PUT_COMMA)
+        Count
+    };
+
+    /// Compile time list of types.
+    template<typename... Ts>
+    struct TypeList {
+        static constexpr uint32_t size = sizeof...(Ts);
+    };
+
+    /// Index of @p T in @p list, or @c list.size if it isn't in it.
+    template<typename T, typename... Ts>
+    constexpr uint32_t indexOf(TypeList<Ts...>) {
+        uint32_t index = 0;
+        bool found = ((std::is_same_v<T, Ts> ? true : (++index, false)) || ...);
+        return found ? index : sizeof...(Ts);
+    }
+
+    /// What setEvent does with a new event while an older event of the same type is still queued.
+    enum struct CoalescePolicy {
+        None,       ///< queue every event.
+        Latest,     ///< overwrite the queued event with the new one.
+        Accumulate, ///< keep the latest state but sum up deltas (eg. MousePositionEvent::m_delta).
+        Debounce,   ///< same as Latest, but hold the event back until a poll where no new event arrived.
     };
 
+    template<typename Event>
+    void setCoalescePolicy(CoalescePolicy policy);
+
+    template<typename Event>
+    CoalescePolicy getCoalescePolicy();
+
+    /// Subscribers are called in ascending @p priority order until one returns true (consumes the
+    /// event). Returns false if @p priority is already taken for this event type.
     template<typename Event>
     bool subscribe(uint16_t priority, functor_t<Event> &&functor);
 
     template<typename Event>
     bool unsubscribe(uint16_t priority);
 
+    /// Observers see every event of this type, even consumed ones, but can't consume it themselves.
+    /// They run at the end of pollEvents(), after all subscribers, in parallel as Jobs.
+    /// Each observer gets its events in order, but different observers run at the same time, so
+    /// an observer may only touch its own state and call postEvent(). pollEvents() returns once
+    /// every observer finished. Returns false if @p id is already taken for this event type.
+    template<typename Event>
+    bool observe(uint16_t id, observer_t<Event> &&observer);
+
+    /// Not callable from an observer.
+    template<typename Event>
+    bool unobserve(uint16_t id);
+
+    /// Pushes @p event onto the back of its type's queue, or merges it into the queued one depending
+    /// on the type's CoalescePolicy. If the queue is full the event is dropped and counted in
+    /// getOverflowCount<Event>().
     template<typename Event>
     void setEvent(Event &&event);
 
+    /// Number of events of this type which were dropped because the queue was full.
+    template<typename Event>
+    uint32_t getOverflowCount();
+
+    /// Thread safe version of setEvent. Moves @p event into this type's inbox without locking or
+    /// allocating, from any thread. It reaches the queue (and its CoalescePolicy) on the next
+    /// drainInbox(). Returns false and drops the event if the inbox is full.
+    template<typename Event>
+    bool postEvent(Event &&event);
+
+    /// Number of events of this type which postEvent dropped because the inbox was full.
+    template<typename Event>
+    uint32_t getInboxOverflowCount();
+
+    /// Moves every posted event into its queue, as if setEvent was called for it. Main thread only.
+    void drainInbox();
+
+    /// Called by drainInbox() with every event of this type it moves, before it is set. Used by
+    /// Recorder, so events posted from other threads are recorded too. nullptr for none.
+    template<typename Event>
+    using drain_callback_t = void(*)(const Event&);
+    template<typename Event>
+    void setDrainCallback(drain_callback_t<Event> callback);
+
+    /// Bit eventIndex<Event> is set for each built-in type which has queued events. Main thread only.
+    uint64_t getPendingMask();
+
+
+    /// Time spent in one subscriber since the last resetDispatchStats(). Only recorded while
+    /// dispatch stats are enabled.
+    struct SubscriberStats {
+        EventType m_type;
+        uint16_t m_priority;
+        uint64_t m_calls;
+        uint64_t m_consumed;    // how many of those calls returned true
+        double m_totalTime;     // in seconds
+        double m_maxTime;
+    };
+
+    /// Times every subscriber call. Does nothing if BIGG_CONFIG_EVENT_STATS is 0.
+    void setDispatchStatsEnabled(bool enabled);
+    bool getDispatchStatsEnabled();
 
+    /// Stats of every current subscriber, sorted by event type then priority.
+    std::vector<SubscriberStats> getDispatchStats();
+    void resetDispatchStats();
+
+    /// Dispatches every queued event of this type, oldest first.
     template<typename Event>
     void pollEvent();
 
-    // defined later since it depends on UpdateEvent, ..., xxxEvent
+    /// Polls every event type which has queued events. Types which didn't fire aren't touched.
+    /// Then dispatches the custom events (see CustomEvents.hpp), runs the observers of the polled
+    /// events and waits for them.
     void pollEvents();
 
-    // reset Events system. Unsubscribe all callbacks, reset all events.
+    // reset Events system. Unsubscribe all callbacks, reset all events. No other thread may be
+    // posting events while this runs.
     void reset();
 
 } // namespace Events
@@ -79,6 +174,7 @@ namespace Events {
     // Runtime Events
     struct UpdateEvent {
         double m_delta;
+        double m_alpha;     // how far this frame is between the last two ticks (0 to 1), for interpolation
         ADD_TYPE_MEMBER(Update)
     };
 
@@ -131,21 +227,26 @@ namespace Events {
         ADD_TYPE_MEMBER(WindowRefresh)
     };
 
+    // Input events carry m_time, the Profile::now() when the context received them. With
+    // Context::setHighFrequencyInput() several arrive per frame, and this says when in the frame.
     struct KeyEvent {
         KeyEnum m_key;
         int m_scancode;
         ActionEnum m_action;
         ModsEnum m_mods;
+        double m_time;
         ADD_TYPE_MEMBER(Key)
     };
     struct CharEvent {
         unsigned int m_codepoint;
+        double m_time;
         ADD_TYPE_MEMBER(Char)
     };
 
     struct MousePositionEvent {
         glm::dvec2 m_mousePosition;
         glm::dvec2 m_delta;
+        double m_time;
         ADD_TYPE_MEMBER(MousePosition)
     };
     struct MouseEnterEvent {
@@ -156,11 +257,13 @@ namespace Events {
         MouseButtonEnum m_button;
         ActionEnum m_action;
         ModsEnum m_mods;
+        double m_time;
         ADD_TYPE_MEMBER(MouseButton)
     };
 
     struct ScrollEvent {
         glm::dvec2 m_delta;
+        double m_time;
         ADD_TYPE_MEMBER(Scroll)
     };
 
@@ -168,4 +271,46 @@ namespace Events {
         std::vector<std::string> m_paths;
         ADD_TYPE_MEMBER(DropPath)
     };
+
+namespace Events {
+
+    template<typename List>
+    struct PopFront;
+    template<typename T, typename... Ts>
+    struct PopFront<TypeList<T, Ts...>> {
+        using type = TypeList<Ts...>;
+    };
+
+    /// Every built-in event type, in FOR_EACH_EVENT order.
+#   define PREPEND_COMMA_EVENT(T) , T ## Event
+    using EventTypes = PopFront<TypeList<void FOR_EACH_EVENT(PREPEND_COMMA_EVENT)>>::type;
+
+    /// Dense index of each event type (0 .. EventTypes::size-1). Used as its bit in the pending mask.
+    template<typename Event>
+    inline constexpr uint32_t eventIndex = indexOf<Event>(EventTypes{});
+
+    static_assert(EventTypes::size == static_cast<uint32_t>(EventType::Count), "EventTypes is out of sync with EventType!");
+    static_assert(eventIndex<DropPathEvent> == static_cast<uint32_t>(DropPathEvent::m_type), "EventTypes is out of sync with EventType!");
+
+    /// How many events of each type can be queued between two polls. Storage for the queue is
+    /// allocated up front, so specialize this for types which arrive in bursts.
+    template<typename Event>
+    inline constexpr uint32_t queueCapacity = g_eventQueueCapacity;
+
+    template<> inline constexpr uint32_t queueCapacity<WindowCreateEvent>  = 4;
+    template<> inline constexpr uint32_t queueCapacity<KeyEvent>           = 64;
+    template<> inline constexpr uint32_t queueCapacity<CharEvent>          = 64;
+    template<> inline constexpr uint32_t queueCapacity<MousePositionEvent> = 64;
+    template<> inline constexpr uint32_t queueCapacity<MouseButtonEvent>   = 32;
+    template<> inline constexpr uint32_t queueCapacity<ScrollEvent>        = 32;
+    template<> inline constexpr uint32_t queueCapacity<DropPathEvent>      = 4;
+
+    /// How many events of each type other threads can post between two drainInbox() calls.
+    template<typename Event>
+    inline constexpr uint32_t inboxCapacity = g_eventInboxCapacity;
+
+    template<> inline constexpr uint32_t inboxCapacity<WindowCreateEvent>  = 4;
+    template<> inline constexpr uint32_t inboxCapacity<DropPathEvent>      = 4;
+
+} // namespace Events
 };  // namespace BIGGEngine
\ No newline at end of file
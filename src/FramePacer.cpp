@@ -0,0 +1,160 @@
+#include "FramePacer.hpp"
+
+#include "Core.hpp"
+
+#include <algorithm>    // for std::sort, std::max
+#include <array>
+#include <chrono>       // for std::chrono::microseconds
+#include <cmath>        // for std::sqrt, std::abs
+#include <thread>       // for std::this_thread
+
+namespace BIGGEngine {
+namespace FramePacer {
+namespace {
+
+    constexpr double g_sleepStep = 1e-3;    // seconds per sleep_for call while sleeping
+
+    double targetFrameRate = g_targetFrameRate;
+    double nextFrameTime = 0.0;             // when the next frame should start. 0 before the first frame.
+    double lastFrameTime = 0.0;
+
+    // running mean and variance of how much longer than g_sleepStep a sleep takes (Welford's algorithm)
+    double overshootMean = 1e-3;
+    double overshootM2 = 0.0;
+    uint64_t overshootCount = 1;
+
+    std::array<double, g_framePacerHistory> frameTimes{};
+    uint32_t frameCount = 0;    // total, frameTimes is a ring buffer
+    uint32_t missedFrames = 0;
+
+    double getOvershootEstimate() {
+        double variance = overshootCount > 1 ? overshootM2 / (double) (overshootCount - 1) : 0.0;
+        return overshootMean + std::sqrt(variance);
+    }
+
+    void addOvershootSample(double overshoot) {
+        overshootCount++;
+        double delta = overshoot - overshootMean;
+        overshootMean += delta / (double) overshootCount;
+        overshootM2 += delta * (overshoot - overshootMean);
+    }
+
+    /// Sleeps while it is safe to, then spins until @p deadline. Calls @p poll every 1/g_inputPollRate seconds.
+    void waitUntil(double deadline, Functor<void()>& poll) {
+        BIGG_PROFILE_RUN_FUNCTION;
+        double now = Profile::now();
+        double nextPoll = now;
+        auto pollIfDue = [&poll, &nextPoll](double time) {
+            if(poll && time >= nextPoll) {
+                poll();
+                nextPoll = time + 1.0 / g_inputPollRate;
+            }
+        };
+
+        pollIfDue(now);
+        while(deadline - now > getOvershootEstimate() + g_sleepStep) {
+            const double before = Profile::now();   // after the poll, so the sample is only the sleep
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(g_sleepStep * 1e6)));
+            now = Profile::now();
+            addOvershootSample(now - before - g_sleepStep);
+            pollIfDue(now);
+        }
+        while((now = Profile::now()) < deadline) {
+            pollIfDue(now);
+            std::this_thread::yield();
+        }
+    }
+
+    void addFrameTime(double frameTime) {
+        frameTimes[frameCount % g_framePacerHistory] = frameTime;
+        frameCount++;
+    }
+
+}   // anonymous namespace
+
+    void setTargetFrameRate(double framesPerSecond) {
+        BIGG_ASSERT(framesPerSecond >= 0.0, "Target frame rate must not be negative!");
+        targetFrameRate = framesPerSecond;
+        nextFrameTime = 0.0;
+    }
+
+    double getTargetFrameRate() {
+        return targetFrameRate;
+    }
+
+    void restartSchedule() {
+        nextFrameTime = 0.0;
+        lastFrameTime = 0.0;
+    }
+
+    double waitForNextFrame(Functor<void()>&& poll) {
+        double now = Profile::now();
+        if(targetFrameRate > 0.0) {
+            double period = 1.0 / targetFrameRate;
+            if(nextFrameTime == 0.0) {
+                nextFrameTime = now;
+            } else {
+                nextFrameTime += period;
+            }
+            if(now - nextFrameTime > period) {
+                // more than a frame late. Restart the schedule instead of catching up.
+                missedFrames++;
+                nextFrameTime = now;
+            }
+            waitUntil(nextFrameTime, poll);
+            now = Profile::now();
+        }
+
+        if(lastFrameTime != 0.0) {
+            addFrameTime(now - lastFrameTime);
+        }
+        lastFrameTime = now;
+        return now;
+    }
+
+    FrameStats getFrameStats() {
+        FrameStats stats;
+        stats.m_frames = std::min(frameCount, g_framePacerHistory);
+        stats.m_missed = missedFrames;
+        stats.m_sleepOvershoot = getOvershootEstimate();
+        if(stats.m_frames == 0) {
+            return stats;
+        }
+
+        std::array<double, g_framePacerHistory> sorted;
+        std::copy_n(frameTimes.begin(), stats.m_frames, sorted.begin());
+        std::sort(sorted.begin(), sorted.begin() + stats.m_frames);
+
+        double period = targetFrameRate > 0.0 ? 1.0 / targetFrameRate : 0.0;
+        double sum = 0.0, jitterSum = 0.0;
+        for(uint32_t i = 0; i < stats.m_frames; i++) {
+            double jitter = std::abs(sorted[i] - period);
+            sum += sorted[i];
+            jitterSum += jitter;
+            stats.m_maxJitter = std::max(stats.m_maxJitter, jitter);
+        }
+        stats.m_mean = sum / stats.m_frames;
+        stats.m_min = sorted[0];
+        stats.m_max = sorted[stats.m_frames - 1];
+        stats.m_p99 = sorted[std::min<uint32_t>(stats.m_frames - 1, static_cast<uint32_t>(stats.m_frames * 0.99))];
+        if(period > 0.0) {
+            stats.m_meanJitter = jitterSum / stats.m_frames;
+        } else {
+            stats.m_maxJitter = 0.0;    // no target to measure against
+        }
+
+        double variance = 0.0;
+        for(uint32_t i = 0; i < stats.m_frames; i++) {
+            variance += (sorted[i] - stats.m_mean) * (sorted[i] - stats.m_mean);
+        }
+        stats.m_stdDev = std::sqrt(variance / stats.m_frames);
+        return stats;
+    }
+
+    void resetFrameStats() {
+        frameCount = 0;
+        missedFrames = 0;
+    }
+
+} // namespace FramePacer
+} // namespace BIGGEngine
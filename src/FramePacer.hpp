@@ -0,0 +1,49 @@
+//      Frame pacing: starts frames at a fixed target rate, independent of how often input arrives.
+
+// Waiting is a hybrid of sleeping and spinning. Sleeping is cheap but the OS wakes the thread up
+// late by a varying amount (often around 1ms), so the pacer sleeps in short steps while the
+// remaining time is larger than the oversleep it has measured, then spins (yielding) for the rest.
+// That keeps frame starts within some microseconds of the target without burning a full core.
+#pragma once
+
+#include "Functor.hpp"
+
+#include <stdint.h>
+
+namespace BIGGEngine {
+namespace FramePacer {
+
+    /// Frames per second. 0 turns pacing off, and the context waits for input or the next tick instead.
+    void setTargetFrameRate(double framesPerSecond);
+    double getTargetFrameRate();
+
+    /// Starts the schedule over from the next frame, without counting it as missed or recording the
+    /// gap as a frame time. For when frames weren't paced by waitForNextFrame() for a while.
+    void restartSchedule();
+
+    /// Blocks until the next frame should start and returns that time (Profile::now()). If a frame
+    /// took longer than the frame period, the next one starts immediately and the schedule restarts
+    /// from there, so late frames aren't followed by a burst of short ones.
+    /// @p poll (if set) is called about g_inputPollRate times per second while waiting, eg. to
+    /// sample input between frames.
+    double waitForNextFrame(Functor<void()>&& poll = nullptr);
+
+    /// Frame times (between two waitForNextFrame() returns) of the last g_framePacerHistory frames.
+    /// Jitter is how far frame times are from the target period. All in seconds.
+    struct FrameStats {
+        uint32_t m_frames = 0;
+        double m_mean = 0.0;
+        double m_min = 0.0;
+        double m_max = 0.0;
+        double m_p99 = 0.0;
+        double m_stdDev = 0.0;
+        double m_meanJitter = 0.0;  // mean of |frame time - target period|
+        double m_maxJitter = 0.0;
+        double m_sleepOvershoot = 0.0;  // current estimate of how late a sleep wakes up
+        uint32_t m_missed = 0;          // frames that started late by more than a frame period
+    };
+    FrameStats getFrameStats();
+    void resetFrameStats();
+
+} // namespace FramePacer
+} // namespace BIGGEngine
@@ -1,23 +1,21 @@
-//      This class is pretty much a simplified version of std::function. It was made for
-//      learning / experimenting purposes, and is not meant to replace std::function.
+//      A move-only replacement for std::function which never allocates. Used for event callbacks,
+//      where std::function's heap allocation and copy semantics aren't needed.
 
 
-// struct Functor
+// struct Functor<Ret(Args...), Capacity>
 // (object which can be called like a function)
 //
-// It has 1 void* of storage on the stack, which is either the lambda / function pointer
-// If the size of the lambda is greater than the size of void*, or if the implementation's
-// size of a function pointer is greater than the size of void*, the storage will instead
-// point to memory in the heap with any size.
+// The callable is always stored inline in Capacity bytes of storage. Trying to store a callable
+// which doesn't fit is a compile error rather than a heap allocation. Increase Capacity for that
+// Functor type, or capture less (eg. capture a pointer to a struct instead of the struct).
 
-// It can safely hold:
-//      a free function pointer
-//      a lambda with no capture
-//      a lambda which captures scalars / plain old data
+// It can hold:
+//      a free function or free function pointer
+//      a lambda with or without captures (including move-only captures like std::unique_ptr)
+//      any other object with a matching call operator
 
-// It can probably safely hold (not extensively tested)
-//      a lambda which captures non-scalars / objects with a lifetime
-//      a lambda which captures raw or smart pointers
+// Trivially copyable callables (function pointers, lambdas capturing only pointers / scalars) are
+// moved with a plain memcpy. Anything else is moved and destroyed through a type-erased manager.
 
 // It is possible to capture a member function like this:
 //      Functor foo([this](auto args){ return this->memberFunction(args); });
@@ -25,119 +23,162 @@
 // which is undefined behaviour.
 #pragma once
 
+#include <cstddef>      // for std::size_t, std::max_align_t
+#include <cstring>      // for std::memcpy
+#include <new>          // for placement new, std::launder
 #include <type_traits>  // for all the SFINAE garbage
-#include "Log.hpp"      // for debug
-#include <functional>
+#include <utility>      // for std::forward, std::move
 
-template<typename Ret, typename ... Args>
-struct Functor {
+#include "Config.hpp"   // for g_functorCapacity
+#include "Log.hpp"      // for BIGG_ASSERT
+
+namespace BIGGEngine {
+
+template<typename Signature, std::size_t Capacity = g_functorCapacity>
+struct Functor;
+
+template<typename Ret, typename ... Args, std::size_t Capacity>
+struct Functor<Ret(Args...), Capacity> {
 
 private:
     // --------------------------- Helper templates ----------------------------------
 
-    // checks if bool T::operator(Arg) exists.
-    // by default derive from std::false_type
-    template <typename T, typename = void>
-    struct is_call_operator_implemented
-            : std::false_type {};
-
-    // If std::invoke_result_t<T, int> is a valid type
-    template <typename T>
-    struct is_call_operator_implemented<T
-            , std::void_t<std::invoke_result_t<T, Args...>>>
-            : std::true_type {};
-
-    template< class T >
-    static inline constexpr bool is_call_operator_implemented_v = is_call_operator_implemented<T>::value;
-
-    typedef Ret(*funcPtrType)(Args...);
-    union Storage {
-        char small[sizeof(void*)];
-        funcPtrType funcPtr;
-    };
-
-    template<typename Func>
-    struct use_small_storage
-            : std::integral_constant<bool, sizeof(Func) <= sizeof(Storage)
-                                           && alignof(Func) <= alignof(Storage)
-                    //&& std::is_trivially_copy_constructible<Func>::value
-                    //&& std::is_trivially_destructible<Func>::value> {};
-            > {};
-
-    template< class T >
-    static inline constexpr bool use_small_storage_v = use_small_storage<T>::value;
+    template<typename T>
+    static inline constexpr bool is_functor_v = std::is_same_v<std::decay_t<T>, Functor>;
+
+    // checks if Ret T::operator(Args...) exists (or T is a function pointer returning Ret).
+    template<typename T>
+    static inline constexpr bool is_callable_v = std::is_invocable_r_v<Ret, std::decay_t<T>&, Args...>;
+
+    template<typename T>
+    static inline constexpr bool fits_in_storage_v = sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t);
+
+    template<typename T>
+    static inline constexpr bool is_trivially_relocatable_v = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+    enum struct Operation { Move, Destroy };
+
+    using InvokeFunction = Ret(*)(void* storage, Args&&... args);
+    using ManageFunction = void(*)(Operation operation, void* storage, void* other);
+
+    template<typename T>
+    static Ret invoke(void* storage, Args&&... args) {
+        return (*std::launder(static_cast<T*>(storage)))(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    static void manage(Operation operation, void* storage, void* other) {
+        T* self = std::launder(static_cast<T*>(storage));
+        switch(operation) {
+            case Operation::Move:       // move-construct other from self, then destroy self
+                ::new(other) T(std::move(*self));
+                self->~T();
+                break;
+            case Operation::Destroy:
+                self->~T();
+                break;
+        }
+    }
 
     // --------------------------- Functor ----------------------------------
 
 private:
-    char lambda[sizeof(void*)];
-    void* funcPtr = nullptr;    // involves type punning a void* to function pointer
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    InvokeFunction m_invoke = nullptr;
+    ManageFunction m_manage = nullptr;  // nullptr if the callable is trivially relocatable
 
 public:
     // Null Function type
-    Functor() {}
+    Functor() noexcept = default;
+    Functor(std::nullptr_t) noexcept {}
 
-    // Free function type
-    template<class Func, std::enable_if_t<std::is_function_v<std::remove_pointer_t<std::decay_t<Func>>>, bool> = true>
+    // Free function, function pointer or lambda type
+    template<class Func, std::enable_if_t<!is_functor_v<Func> && is_callable_v<Func>, bool> = true>
     Functor(Func&& func) {
-        static_assert(std::is_same_v<Ret, std::invoke_result_t<Func, Args...>>, "Function pointer must return type Ret.");
+        using T = std::decay_t<Func>;
+        static_assert(fits_in_storage_v<T>, "Callable doesn't fit into the Functor's storage! Capture less or increase Capacity.");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "Callable must be nothrow move constructible.");
+
+        // only a pointer can be null, not a reference to a free function (which also decays to one)
+        using Arg = std::remove_reference_t<Func>;
+        if constexpr(std::is_pointer_v<Arg> || std::is_member_pointer_v<Arg>) {
+            if(func == nullptr) return;    // stay empty
+        }
 
-        BIGG_LOG_TRACE("constructing function.\n");
-        funcPtr = func; // a function will be implicitly converted to a function pointer
-//        invokeFunction = [](Storage& storage, Args... args) -> Ret { return (*storage.funcPtr)(std::forward<Args>(args)...); };
-        return;
+        // placement new into the inline storage
+        ::new(static_cast<void*>(m_storage)) T(std::forward<Func>(func));
+        m_invoke = &invoke<T>;
+        if constexpr(!is_trivially_relocatable_v<T>) {
+            m_manage = &manage<T>;
+        }
     }
 
-    // Lambda functor type
-    template<class Lambda, std::enable_if_t<!std::is_function_v<std::remove_pointer_t<std::decay_t<Lambda>>>, bool> = true>
-    Functor(Lambda&& lambda) {
-        static_assert(is_call_operator_implemented_v<Lambda>, "Call operator is not implemented on this object! (It is not a lambda or functor).");
-        static_assert(std::is_same_v<Ret, std::invoke_result_t<Lambda, Args...>>, "Lambda must return type Ret.");
-        static_assert(use_small_storage_v<Lambda>, "Lambda must be at most 'sizeof(void*)' bytes in size!");
-
-        // placement new into the stack memory
-        BIGG_LOG_TRACE("constructing small lambda.\n");
-        funcPtr = new (&lambda) std::decay_t<Lambda>(std::move(lambda));
-//        invokeFunction = [](Storage& storage, Args... args) -> Ret { return (*reinterpret_cast<std::decay_t<Lambda>*>(&storage.small))(std::forward<Args>(args)...); };
-//        destroyFunction = [](Storage& storage){ reinterpret_cast<std::decay_t<Lambda>*>(&storage.small)->~Lambda(); };
+    // move only.
+    Functor(const Functor&) = delete;
+    Functor& operator=(const Functor&) = delete;
+
+    Functor(Functor&& other) noexcept {
+        moveFrom(other);
     }
 
-    // copy constructor
-    Functor(const Functor& other) : lambda(other.lambda), funcPtr(other.funcPtr) {
-        if(other.funcPtr == &other.lambda) {
-            // its a lambda for sure. Point this->funcPtr to this->lambda
-            funcPtr = &lambda;
+    Functor& operator=(Functor&& other) noexcept {
+        if(this != &other) {
+            reset();
+            moveFrom(other);
         }
+        return *this;
     }
 
-    // move constructor
-    Functor(Functor&& other) : lambda(other.lambda), funcPtr(other.funcPtr) {
-        if(other.funcPtr == &other.lambda) {
-            // its a lambda for sure. Point this->funcPtr to this->lambda
-            funcPtr = &lambda;
-            other.funcPtr = funcPtr;
-        } else {
-            other.funcPtr = nullptr;
-        }
+    Functor& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
     }
 
-    // move assignment
-    Functor& operator=(Functor&& other) = default;
+    ~Functor() {
+        reset();
+    }
 
-    // destructor (not allowed to be templated so I save the destruction code during construction and call it here)
-//    ~Functor() {
-//        destroyFunction(storage);
-//    }
+    explicit operator bool() const noexcept {
+        return m_invoke != nullptr;
+    }
 
     Ret operator()(Args... args) {
-//        return invokeFunction(storage, std::forward<Args>(args)...);
-        if(funcPtr) {
-            return (*funcPtr)(std::forward<Args>(args)...);
+        BIGG_ASSERT(m_invoke != nullptr, "Trying to call a non-initialized Functor.");
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+private:
+    void reset() noexcept {
+        if(m_manage) {
+            m_manage(Operation::Destroy, m_storage, nullptr);
         }
-        BIGG_LOG_WARN("Trying to call a non-initialized Functor.");
-        return Ret();   // idk
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+    // expects this to be empty. Leaves other empty.
+    void moveFrom(Functor& other) noexcept {
+        if(!other.m_invoke) return;
+
+        if(other.m_manage) {
+            other.m_manage(Operation::Move, other.m_storage, m_storage);
+        } else {
+            std::memcpy(m_storage, other.m_storage, Capacity);
+        }
+        m_invoke = other.m_invoke;
+        m_manage = other.m_manage;
+        other.m_invoke = nullptr;
+        other.m_manage = nullptr;
     }
 };
 
+/// Callback type for Events::subscribe. Events are passed by const reference so no subscriber
+/// copies the event.
 template<typename Event>
-using EventFunctor = Functor<bool, Event>;
\ No newline at end of file
+using EventFunctor = Functor<bool(const Event&)>;
+
+/// Callback type for Events::observe. Observers can't consume the event, so they return nothing.
+template<typename Event>
+using ObserverFunctor = Functor<void(const Event&)>;
+
+} // namespace BIGGEngine
@@ -0,0 +1,242 @@
+#include "Jobs.hpp"
+
+#include "Core.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>   // for std::unique_ptr
+#include <thread>
+
+#define BIGG_PROFILE_JOBS_FUNCTION                  _BIGG_PROFILE_CATEGORY_FUNCTION("jobs")
+
+namespace BIGGEngine {
+namespace Jobs {
+namespace {
+
+    /// One per worker, plus index 0 for every other thread.
+    struct Queue {
+        std::mutex m_mutex;
+        std::deque<Job> m_jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    Queue mainThreadQueue;      // Affinity::MainThread jobs, never stolen
+
+    std::atomic<uint32_t> queuedJobs{0};    // in queues, not counting mainThreadQueue
+    std::atomic<uint32_t> sleepingWorkers{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stop = false;          // guarded by sleepMutex
+
+    thread_local uint32_t threadIndex = 0;
+    std::thread::id frameThread;    // set by init(), the only thread which runs mainThreadQueue
+
+    void push(Job&& job) {
+        if(job.m_affinity == Affinity::MainThread) {
+            std::lock_guard<std::mutex> lock(mainThreadQueue.m_mutex);
+            mainThreadQueue.m_jobs.push_back(std::move(job));
+            return;
+        }
+        {
+            Queue& queue = *queues[threadIndex];
+            std::lock_guard<std::mutex> lock(queue.m_mutex);
+            queue.m_jobs.push_back(std::move(job));
+        }
+        // A worker going to sleep increments sleepingWorkers before it checks queuedJobs, so
+        // either it sees this job or this sees it sleeping.
+        queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+        if(sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    bool popBack(Queue& queue, Job& out) {
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if(queue.m_jobs.empty()) return false;
+        out = std::move(queue.m_jobs.back());
+        queue.m_jobs.pop_back();
+        return true;
+    }
+
+    bool popFront(Queue& queue, Job& out) {
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if(queue.m_jobs.empty()) return false;
+        out = std::move(queue.m_jobs.front());
+        queue.m_jobs.pop_front();
+        return true;
+    }
+
+    /// The newest job of this thread's own deque, else the oldest one of another deque.
+    bool take(Job& out) {
+        if(queuedJobs.load(std::memory_order_relaxed) == 0) return false;
+
+        const uint32_t count = static_cast<uint32_t>(queues.size());
+        bool found = popBack(*queues[threadIndex], out);
+        for(uint32_t i = 1; !found && i < count; i++) {
+            found = popFront(*queues[(threadIndex + i) % count], out);
+        }
+        if(found) {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return found;
+    }
+
+    void execute(Job& job) {
+        {
+            BIGG_PROFILE_JOBS_FUNCTION;
+            job.m_function();
+        }
+        if(job.m_counter != nullptr) {
+            finish(*job.m_counter);
+        }
+    }
+
+    void workerLoop(uint32_t index) {
+        threadIndex = index;
+        BIGG_PROFILE_THREAD_NAME(fmt::format("Job Worker {:d}", index));
+
+        Job job;
+        for(;;) {
+            if(take(job)) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            wake.wait(lock, []() { return stop || queuedJobs.load(std::memory_order_seq_cst) > 0; });
+            sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+            if(stop) return;
+        }
+    }
+
+    /// Stops the workers at exit if shutdown() wasn't called, like a static thread pool would.
+    struct ShutdownAtExit {
+        ~ShutdownAtExit() { shutdown(); }
+    } shutdownAtExit;
+
+}   // anonymous namespace
+
+    void add(Counter& counter) {
+        counter.m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finish(Counter& counter) {
+        // Under the lock, so a runAfter() either sees the count reach zero or its job gets taken here.
+        std::vector<Job> continuations;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+            if(counter.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter.m_continuations);
+            }
+        }
+        for(Job& job : continuations) {
+            push(std::move(job));
+        }
+    }
+
+    void init(uint32_t workerCount) {
+        BIGG_PROFILE_INIT_FUNCTION;
+        BIGG_ASSERT(workers.empty(), "Jobs::init() was called twice!");
+        if(workerCount == 0) {
+            const uint32_t cores = std::thread::hardware_concurrency();
+            workerCount = cores > 1 ? cores - 1 : 1;
+        }
+
+        stop = false;
+        queues.clear();
+        for(uint32_t i = 0; i <= workerCount; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        frameThread = std::this_thread::get_id();
+        for(uint32_t i = 1; i <= workerCount; i++) {
+            workers.emplace_back(workerLoop, i);
+        }
+    }
+
+    void shutdown() {
+        if(workers.empty()) return;
+
+        // finish what is queued, so no counter is left waiting
+        Job job;
+        while(take(job)) {
+            execute(job);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for(std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    uint32_t getWorkerCount() {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    uint32_t getThreadIndex() {
+        return threadIndex;
+    }
+
+    void run(JobFunction&& function, Counter* counter, Affinity affinity) {
+        if(queues.empty()) {
+            init();
+        }
+        if(counter != nullptr) {
+            add(*counter);
+        }
+        push(Job{std::move(function), counter, affinity});
+    }
+
+    void runAfter(Counter& dependency, JobFunction&& function, Counter* counter, Affinity affinity) {
+        if(counter != nullptr) {
+            add(*counter);
+        }
+        {
+            std::lock_guard<std::mutex> lock(dependency.m_mutex);
+            if(!dependency.isDone()) {
+                dependency.m_continuations.push_back(Job{std::move(function), counter, affinity});
+                return;
+            }
+        }
+        if(queues.empty()) {
+            init();
+        }
+        push(Job{std::move(function), counter, affinity});
+    }
+
+    bool isFrameThread() {
+        return std::this_thread::get_id() == frameThread;
+    }
+
+    void wait(const Counter& counter) {
+        BIGG_PROFILE_JOBS_FUNCTION;
+        const bool onFrameThread = isFrameThread();
+        Job job;
+        while(!counter.isDone()) {
+            if((onFrameThread && popFront(mainThreadQueue, job)) || take(job)) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void runMainThreadJobs() {
+        if(queues.empty()) {
+            init();
+        }
+        BIGG_ASSERT(isFrameThread(), "Jobs::runMainThreadJobs() called off the frame thread, call Jobs::init() on it first!");
+        Job job;
+        while(popFront(mainThreadQueue, job)) {
+            execute(job);
+        }
+    }
+
+} // namespace Jobs
+} // namespace BIGGEngine
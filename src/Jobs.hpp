@@ -0,0 +1,122 @@
+//      Work-stealing job system. Small functions (jobs) run on a pool of worker threads and on the
+//      thread which waits for them.
+
+// Every thread has its own deque of jobs. A thread pushes and pops jobs at the back of its own
+// deque (newest first, so the data is still in cache) and idle workers steal from the front of
+// the others' deques (oldest first, usually the biggest pieces of work). Threads which aren't
+// workers (the main thread, and the engine thread in render thread mode) share deque 0.
+
+// Progress is tracked with Counters: every job started with a counter increments it and
+// decrements it when done. wait() runs other jobs until the counter is zero, and runAfter()
+// starts a job once a counter is zero, which is how dependencies are expressed.
+
+// Jobs with Affinity::MainThread only run on the frame thread, the one which runs
+// Context::runFrame(): in runMainThreadJobs() (once per frame) or while it waits. That is the
+// engine thread in render thread mode, not the thread which owns the window. Use it for work
+// which has to stay on the frame thread, eg. bgfx calls or setting events.
+#pragma once
+
+#include "Functor.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+namespace BIGGEngine {
+namespace Jobs {
+
+    using JobFunction = Functor<void()>;
+
+    enum struct Affinity : uint8_t {
+        Any,
+        MainThread,
+    };
+
+    struct Counter;
+
+    struct Job {
+        JobFunction m_function;
+        Counter* m_counter = nullptr;
+        Affinity m_affinity = Affinity::Any;
+    };
+
+    /// Number of unfinished jobs started with it. Must outlive them, so usually lives on the stack
+    /// of the function which waits for it.
+    struct Counter {
+        Counter() = default;
+        /// Waits for a finish() which already made the count zero to let go of the counter.
+        ~Counter() { std::lock_guard<std::mutex> lock(m_mutex); }
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+        bool isDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend void add(Counter&);
+        friend void finish(Counter&);
+        friend void runAfter(Counter&, JobFunction&&, Counter*, Affinity);
+
+        std::atomic<uint32_t> m_count{0};
+        std::mutex m_mutex;                 // the count only reaches 0 under it, see runAfter()
+        std::vector<Job> m_continuations;   // runAfter() jobs waiting for this counter
+    };
+
+    /// Starts @p workerCount worker threads, 0 for one less than the number of cores (at least 1).
+    /// The calling thread becomes the frame thread, so call it from there. Otherwise the first
+    /// run() or frame does, with the default number of workers.
+    void init(uint32_t workerCount = g_jobWorkerCount);
+    /// Waits for the workers to run out of jobs and stops them. Called at exit if needed.
+    void shutdown();
+
+    uint32_t getWorkerCount();
+    /// 1 to getWorkerCount() on a worker, 0 on every other thread.
+    uint32_t getThreadIndex();
+
+    /// Queues @p function. @p counter (if not nullptr) is incremented now and decremented once it ran.
+    void run(JobFunction&& function, Counter* counter = nullptr, Affinity affinity = Affinity::Any);
+
+    /// Same as run(), but only queues @p function once @p dependency is zero.
+    void runAfter(Counter& dependency, JobFunction&& function, Counter* counter = nullptr, Affinity affinity = Affinity::Any);
+
+    /// True on the thread init() was called on.
+    bool isFrameThread();
+
+    /// Runs queued jobs until @p counter is zero. On the frame thread this includes MainThread jobs.
+    void wait(const Counter& counter);
+
+    /// Runs every queued MainThread job. Call on the frame thread.
+    void runMainThreadJobs();
+
+    /// Calls @p func(entity, Component&...) for every entity with all of @p Component, split into jobs
+    /// of @p grainSize entities, and waits for them. @p func may change the components, but not add
+    /// or remove components or entities.
+    template<typename... Component, typename Func>
+    void parallelForEach(entt::registry& registry, Func&& func, uint32_t grainSize = g_jobGrainSize) {
+        auto view = registry.view<Component...>();
+
+        std::vector<entt::entity> entities;
+        for(const entt::entity entity : view) {
+            entities.push_back(entity);
+        }
+
+        const uint32_t count = static_cast<uint32_t>(entities.size());
+        auto runRange = [&view, &func, data = entities.data()](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; i++) {
+                func(data[i], view.template get<Component>(data[i])...);
+            }
+        };
+
+        Counter counter;
+        for(uint32_t begin = grainSize; begin < count; begin += grainSize) {
+            const uint32_t end = begin + grainSize < count ? begin + grainSize : count;
+            run([&runRange, begin, end]() { runRange(begin, end); }, &counter);
+        }
+        runRange(0, grainSize < count ? grainSize : count);  // the first range on this thread
+        wait(counter);
+    }
+
+} // namespace Jobs
+} // namespace BIGGEngine
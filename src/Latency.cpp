@@ -0,0 +1,141 @@
+#include "Latency.hpp"
+
+#include "Core.hpp"
+
+#include <algorithm>    // for std::sort, std::min
+
+namespace BIGGEngine {
+namespace Latency {
+namespace {
+
+    struct Sample {
+        double m_input = 0.0;                           // m_time of the input
+        std::array<double, g_stageCount> m_latency{};   // per stage, < 0 if it didn't reach it
+    };
+
+    bool following = false;
+    bool waitingForTick = false;    // reached Stage::Frame, completes with the next tick
+    Sample current;
+    uint32_t nextStage = 0;     // mark() ignores earlier stages
+
+    std::array<Sample, g_latencyHistory> history;
+    uint32_t sampleCount = 0;   // total, history is a ring buffer
+
+    template<typename Event>
+    bool onInput(const Event& e) {
+        if(!following) {
+            following = true;
+            waitingForTick = false;
+            current.m_input = e.m_time;
+            current.m_latency.fill(-1.0);
+            nextStage = 0;
+            mark(Stage::Dispatch);
+        }
+        return false;
+    }
+
+    void addSample() {
+        history[sampleCount % g_latencyHistory] = current;
+        sampleCount++;
+        following = false;
+        waitingForTick = false;
+
+        BIGG_PROFILE_COUNTER("input latency (ms)", "\"dispatch\": {:.3f}, \"frame\": {:.3f}",
+                             current.m_latency[static_cast<uint32_t>(Stage::Dispatch)] * 1e3,
+                             current.m_latency[static_cast<uint32_t>(Stage::Frame)] * 1e3);
+    }
+
+}   // anonymous namespace
+
+    const char* getStageName(Stage stage) {
+        switch(stage) {
+            case Stage::Dispatch:   return "Dispatch";
+            case Stage::Script:     return "Script";
+            case Stage::Tick:       return "Tick";
+            case Stage::Submit:     return "Submit";
+            case Stage::Frame:      return "Frame";
+            default:                return "Unknown";
+        }
+    }
+
+    void init() {
+        const bool subscribed = Events::subscribe<KeyEvent>(g_latencyPriority, onInput<KeyEvent>)
+                && Events::subscribe<CharEvent>(g_latencyPriority, onInput<CharEvent>)
+                && Events::subscribe<MousePositionEvent>(g_latencyPriority, onInput<MousePositionEvent>)
+                && Events::subscribe<MouseButtonEvent>(g_latencyPriority, onInput<MouseButtonEvent>)
+                && Events::subscribe<ScrollEvent>(g_latencyPriority, onInput<ScrollEvent>);
+        BIGG_ASSERT(subscribed, "Latency couldn't subscribe to input events at priority {:d}!", g_latencyPriority);
+    }
+
+    void mark(Stage stage) {
+        const uint32_t index = static_cast<uint32_t>(stage);
+        if(!following) {
+            return;
+        }
+        constexpr uint32_t tick = static_cast<uint32_t>(Stage::Tick);
+        if(stage == Stage::Tick) {
+            // Ticks run at their own rate, before the frame's input is dispatched, so the first one
+            // after the input often comes after its frame. It is recorded whenever it happens.
+            if(current.m_latency[tick] < 0.0) {
+                current.m_latency[tick] = Profile::now() - current.m_input;
+                if(waitingForTick) {
+                    addSample();
+                }
+            }
+            return;
+        }
+        if(index < nextStage) {
+            return;
+        }
+        current.m_latency[index] = Profile::now() - current.m_input;
+        nextStage = index + 1;
+        if(stage == Stage::Frame) {
+            if(current.m_latency[tick] >= 0.0) {
+                addSample();
+            } else {
+                waitingForTick = true;
+            }
+        }
+    }
+
+    Stats getStats() {
+        Stats stats;
+        stats.m_samples = std::min(sampleCount, g_latencyHistory);
+
+        std::array<double, g_latencyHistory> sorted;
+        for(uint32_t stage = 0; stage < g_stageCount; stage++) {
+            StageStats& stageStats = stats.m_stages[stage];
+            double sum = 0.0;
+            for(uint32_t i = 0; i < stats.m_samples; i++) {
+                const double latency = history[i].m_latency[stage];
+                if(latency >= 0.0) {
+                    sorted[stageStats.m_samples++] = latency;
+                    sum += latency;
+                }
+            }
+            if(stageStats.m_samples == 0) {
+                continue;
+            }
+            std::sort(sorted.begin(), sorted.begin() + stageStats.m_samples);
+            stageStats.m_mean = sum / stageStats.m_samples;
+            stageStats.m_p50 = sorted[stageStats.m_samples / 2];
+            stageStats.m_p99 = sorted[std::min<uint32_t>(stageStats.m_samples - 1, static_cast<uint32_t>(stageStats.m_samples * 0.99))];
+            stageStats.m_max = sorted[stageStats.m_samples - 1];
+        }
+
+        for(uint32_t i = 0; i < stats.m_samples; i++) {
+            const double latency = history[i].m_latency[static_cast<uint32_t>(Stage::Frame)];
+            const uint32_t bucket = static_cast<uint32_t>(latency / g_latencyHistogramBucket);
+            stats.m_histogram[std::min(bucket, g_latencyHistogramBuckets - 1)]++;
+        }
+        return stats;
+    }
+
+    void resetStats() {
+        sampleCount = 0;
+        following = false;
+        waitingForTick = false;
+    }
+
+} // namespace Latency
+} // namespace BIGGEngine
@@ -0,0 +1,57 @@
+//      Input-to-photon latency. Follows the oldest input event which isn't on screen yet through
+//      the frame and records how long after its m_time (see KeyEvent) it reached each Stage.
+
+// Only one input is followed at a time. Input which arrives while one is followed is usually drawn
+// by the same frame, so the followed one has the highest latency. A sample is complete once it
+// reached both Stage::Frame and Stage::Tick, so every sample has every stage except Script.
+#pragma once
+
+#include "Config.hpp"
+
+#include <array>
+#include <stdint.h>
+
+namespace BIGGEngine {
+namespace Latency {
+
+    enum struct Stage : uint8_t {
+        Dispatch,   // reached its first subscriber
+        Script,     // a script callback ran for it. Only input which scripts handle reaches this.
+        Tick,       // the next TickEvents ran, so ECS systems have seen it. Often after Frame, see mark().
+        Submit,     // the draw calls of a frame which includes it were submitted
+        Frame,      // bgfx::frame() returned for that frame. As close to the screen as the engine sees.
+        Count
+    };
+    constexpr uint32_t g_stageCount = static_cast<uint32_t>(Stage::Count);
+
+    const char* getStageName(Stage stage);
+
+    /// Subscribes to the input events at g_latencyPriority.
+    void init();
+
+    /// Records that the followed input reached @p stage, unless it already reached it or a later
+    /// one. Tick is the exception: it is recorded whenever the first tick after the input runs, which
+    /// may be frames later. Called by the engine at each stage, from the thread which dispatches events.
+    void mark(Stage stage);
+
+    /// In seconds after the input's m_time, over the samples which reached the stage.
+    struct StageStats {
+        uint32_t m_samples = 0;
+        double m_mean = 0.0;
+        double m_p50 = 0.0;
+        double m_p99 = 0.0;
+        double m_max = 0.0;
+    };
+
+    /// Of the last g_latencyHistory samples.
+    struct Stats {
+        uint32_t m_samples = 0;
+        std::array<StageStats, g_stageCount> m_stages{};
+        /// Stage::Frame latencies in g_latencyHistogramBucket wide buckets, the last one holds the rest.
+        std::array<uint32_t, g_latencyHistogramBuckets> m_histogram{};
+    };
+    Stats getStats();
+    void resetStats();
+
+} // namespace Latency
+} // namespace BIGGEngine
@@ -71,7 +71,7 @@ private:
 #   else
         struct timespec ts;
         clock_gettime(s_clockid, &ts);
-        return = ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+        return ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
 #   endif
     }
 
@@ -132,6 +132,14 @@ private:
 #define _BIGG_PROFILE_CATEGORY_SCOPE(_category, _format, ...)   _BIGG_PROFILE_CATEGORY_CUSTOM(_category, fmt::format("{} {}", prettyFunction, _format), ##__VA_ARGS__)
 // _BIGG_PROFILE_CATEGORY_SCOPE("run", "Events Type: {:s}",GET_EVENT_DEBUG_STRING(event))
 
+// Names the calling thread's track in the trace. The pattern already wrote "ph": "X", the later
+// "ph" key wins when the trace is parsed, which turns this into a metadata event.
+#define BIGG_PROFILE_THREAD_NAME(_name) BIGGEngine::Log::m_profileLogger->debug("\"ph\": \"M\", \"name\": \"thread_name\", \"args\": {{\"name\": \"{:s}\"}}", _name)
+
+// Adds a sample to a counter track (a graph) in the trace, the same way. @p _format is the
+// contents of its "args" object, eg. "\"frame\": {:f}".
+#define BIGG_PROFILE_COUNTER(_name, _format, ...) BIGGEngine::Log::m_profileLogger->debug("\"ph\": \"C\", \"name\": \"{:s}\", \"ts\": {:f}, \"args\": {{" _format "}}", _name, BIGGEngine::Profile::now()*1e6, ##__VA_ARGS__)
+
 //common categories
 #define BIGG_PROFILE_INIT_FUNCTION                  _BIGG_PROFILE_CATEGORY_FUNCTION("init")
 #define BIGG_PROFILE_INIT_SCOPE(_format, ...)       _BIGG_PROFILE_CATEGORY_SCOPE("init", _format, ##__VA_ARGS__)
@@ -0,0 +1,269 @@
+#include "Recorder.hpp"
+
+#include "Core.hpp"
+
+#include <algorithm>    // for std::sort
+#include <array>
+#include <cstdio>       // for FILE, fopen, fread, fwrite
+#include <cstring>      // for std::memcmp
+#include <tuple>        // for std::apply
+#include <type_traits>  // for std::is_trivially_copyable_v, std::is_empty_v
+
+namespace BIGGEngine {
+namespace Recorder {
+namespace {
+
+    constexpr char g_magic[4] = {'B', 'G', 'E', 'V'};
+    constexpr uint16_t g_version = 4;     // 2: UpdateEvent::m_alpha, 3: input event m_time, 4: no padding
+
+    FILE* recordFile = nullptr;
+    double recordStartTime = 0.0;
+
+    FILE* replayFile = nullptr;
+
+    template<typename T>
+    bool writeValue(FILE* file, const T& value) {
+        return std::fwrite(&value, sizeof(T), 1, file) == 1;
+    }
+
+    template<typename T>
+    bool readValue(FILE* file, T& value) {
+        return std::fread(&value, sizeof(T), 1, file) == 1;
+    }
+
+    bool writeString(FILE* file, const std::string& string) {
+        return writeValue(file, static_cast<uint32_t>(string.size()))
+            && std::fwrite(string.data(), 1, string.size(), file) == string.size();
+    }
+
+    bool readString(FILE* file, std::string& string) {
+        uint32_t size;
+        if(!readValue(file, size)) return false;
+        string.resize(size);
+        return std::fread(string.data(), 1, size, file) == size;
+    }
+
+    // The members of each event, in the order they are written. Member by member, so neither
+    // padding nor the struct layout end up in the file. Empty events use the default.
+    template<typename Event>
+    constexpr auto fields = std::tuple<>{};
+    template<> constexpr auto fields<UpdateEvent> = std::make_tuple(&UpdateEvent::m_delta, &UpdateEvent::m_alpha);
+    template<> constexpr auto fields<TickEvent> = std::make_tuple(&TickEvent::m_delta);
+    template<> constexpr auto fields<WindowCreateEvent> = std::make_tuple(&WindowCreateEvent::m_size, &WindowCreateEvent::m_title);
+    template<> constexpr auto fields<WindowSizeEvent> = std::make_tuple(&WindowSizeEvent::m_size);
+    template<> constexpr auto fields<WindowFramebufferSizeEvent> = std::make_tuple(&WindowFramebufferSizeEvent::m_size);
+    template<> constexpr auto fields<WindowContentScaleEvent> = std::make_tuple(&WindowContentScaleEvent::m_scale);
+    template<> constexpr auto fields<WindowPositionEvent> = std::make_tuple(&WindowPositionEvent::m_position);
+    template<> constexpr auto fields<WindowIconifyEvent> = std::make_tuple(&WindowIconifyEvent::m_iconified);
+    template<> constexpr auto fields<WindowMaximizeEvent> = std::make_tuple(&WindowMaximizeEvent::m_maximized);
+    template<> constexpr auto fields<WindowFocusEvent> = std::make_tuple(&WindowFocusEvent::m_focused);
+    template<> constexpr auto fields<KeyEvent> = std::make_tuple(&KeyEvent::m_key, &KeyEvent::m_scancode, &KeyEvent::m_action, &KeyEvent::m_mods, &KeyEvent::m_time);
+    template<> constexpr auto fields<CharEvent> = std::make_tuple(&CharEvent::m_codepoint, &CharEvent::m_time);
+    template<> constexpr auto fields<MousePositionEvent> = std::make_tuple(&MousePositionEvent::m_mousePosition, &MousePositionEvent::m_delta, &MousePositionEvent::m_time);
+    template<> constexpr auto fields<MouseEnterEvent> = std::make_tuple(&MouseEnterEvent::m_entered);
+    template<> constexpr auto fields<MouseButtonEvent> = std::make_tuple(&MouseButtonEvent::m_button, &MouseButtonEvent::m_action, &MouseButtonEvent::m_mods, &MouseButtonEvent::m_time);
+    template<> constexpr auto fields<ScrollEvent> = std::make_tuple(&ScrollEvent::m_delta, &ScrollEvent::m_time);
+    template<> constexpr auto fields<DropPathEvent> = std::make_tuple(&DropPathEvent::m_paths);
+
+    template<typename T>
+    bool writeField(FILE* file, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Add a writeField and readField overload for this member!");
+        return writeValue(file, value);
+    }
+    bool writeField(FILE* file, const std::string& string) {
+        return writeString(file, string);
+    }
+    bool writeField(FILE* file, const std::vector<std::string>& strings) {
+        if(!writeValue(file, static_cast<uint32_t>(strings.size()))) return false;
+        for(const std::string& string : strings) {
+            if(!writeString(file, string)) return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool readField(FILE* file, T& value) {
+        return readValue(file, value);
+    }
+    bool readField(FILE* file, std::string& string) {
+        return readString(file, string);
+    }
+    bool readField(FILE* file, std::vector<std::string>& strings) {
+        uint32_t count;
+        if(!readValue(file, count)) return false;
+        strings.resize(count);
+        for(std::string& string : strings) {
+            if(!readString(file, string)) return false;
+        }
+        return true;
+    }
+
+    template<typename Event>
+    bool writePayload(FILE* file, const Event& e) {
+        static_assert(std::is_empty_v<Event> || std::tuple_size_v<decltype(fields<Event>)> > 0, "List the members of this event in fields!");
+        return std::apply([file, &e](auto... members) { return (writeField(file, e.*members) && ...); }, fields<Event>);
+    }
+
+    template<typename Event>
+    bool readPayload(FILE* file, Event& e) {
+        return std::apply([file, &e](auto... members) { return (readField(file, e.*members) && ...); }, fields<Event>);
+    }
+
+    /// Reads one event's payload and sets it. Returns false if the file ended early.
+    using ReplayFunction = bool(*)(FILE*);
+
+    template<typename Event>
+    bool replayEvent(FILE* file) {
+        Event e;
+        if(!readPayload(file, e)) return false;
+        Events::setEvent<Event>(std::move(e));
+        return true;
+    }
+
+    template<typename... Ts>
+    constexpr std::array<ReplayFunction, sizeof...(Ts)> makeReplayTable(Events::TypeList<Ts...>) {
+        return {&replayEvent<Ts>...};
+    }
+
+    // replayEvent<Event> for each type, indexed by Events::eventIndex<Event>.
+    constexpr std::array<ReplayFunction, Events::EventTypes::size> replayTable = makeReplayTable(Events::EventTypes{});
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5)];
+    }
+
+} // anonymous namespace
+
+    bool startRecording(const std::string& path) {
+        stopRecording();
+
+        recordFile = std::fopen(path.c_str(), "wb");
+        if(recordFile == nullptr) {
+            BIGG_LOG_WARN("Couldn't open '{:s}' to record events!", path);
+            return false;
+        }
+        std::fwrite(g_magic, 1, sizeof(g_magic), recordFile);
+        writeValue(recordFile, g_version);
+        writeValue(recordFile, static_cast<uint16_t>(Events::EventTypes::size));
+
+        recordStartTime = Profile::now();
+#       define SET_DRAIN_CALLBACK(T) Events::setDrainCallback<T ## Event>(&record<T ## Event>);
+        FOR_EACH_EVENT(SET_DRAIN_CALLBACK)
+        BIGG_LOG_INFO("Recording events to '{:s}'.", path);
+        return true;
+    }
+
+    void stopRecording() {
+        if(recordFile != nullptr) {
+#           define CLEAR_DRAIN_CALLBACK(T) Events::setDrainCallback<T ## Event>(nullptr);
+            FOR_EACH_EVENT(CLEAR_DRAIN_CALLBACK)
+            std::fclose(recordFile);
+            recordFile = nullptr;
+        }
+    }
+
+    bool isRecording() {
+        return recordFile != nullptr;
+    }
+
+    template<typename Event>
+    void record(const Event& e) {
+        if(recordFile == nullptr) return;
+
+        bool ok = writeValue(recordFile, static_cast<uint8_t>(Events::eventIndex<Event>))
+               && writeValue(recordFile, Profile::now() - recordStartTime)
+               && writePayload(recordFile, e);
+        if(!ok) {
+            BIGG_LOG_WARN("Failed to write a {:s} event, stopping the recording!", Debug::g_eventTypeDebugStrings.at(Event::m_type));
+            stopRecording();
+        }
+    }
+
+    bool openReplay(const std::string& path) {
+        closeReplay();
+
+        replayFile = std::fopen(path.c_str(), "rb");
+        if(replayFile == nullptr) {
+            BIGG_LOG_WARN("Couldn't open recording '{:s}'!", path);
+            return false;
+        }
+
+        char magic[4];
+        uint16_t version, typeCount;
+        if(std::fread(magic, 1, sizeof(magic), replayFile) != sizeof(magic) || std::memcmp(magic, g_magic, sizeof(magic)) != 0
+           || !readValue(replayFile, version) || !readValue(replayFile, typeCount)) {
+            BIGG_LOG_WARN("'{:s}' isn't an event recording!", path);
+            closeReplay();
+            return false;
+        }
+        if(version != g_version || typeCount != Events::EventTypes::size) {
+            BIGG_LOG_WARN("'{:s}' was recorded by an incompatible version (format {:d}, {:d} event types)!", path, version, typeCount);
+            closeReplay();
+            return false;
+        }
+        return true;
+    }
+
+    void closeReplay() {
+        if(replayFile != nullptr) {
+            std::fclose(replayFile);
+            replayFile = nullptr;
+        }
+    }
+
+    bool replayFrame() {
+        if(replayFile == nullptr) return false;
+
+        uint8_t index;
+        double timestamp;
+        while(readValue(replayFile, index) && readValue(replayFile, timestamp)) {
+            if(index >= replayTable.size() || !replayTable[index](replayFile)) {
+                BIGG_LOG_WARN("Event recording is corrupt at {:.3f}s, stopping the replay.", timestamp);
+                break;
+            }
+            if(index == Events::eventIndex<UpdateEvent>) {
+                return true;
+            }
+        }
+        closeReplay();
+        return false;
+    }
+
+    ReplayStats runReplay(const std::string& path) {
+        BIGG_PROFILE_RUN_FUNCTION;
+        ReplayStats stats;
+        if(!openReplay(path)) return stats;
+
+        while(true) {
+            double start = Profile::now();
+            if(!replayFrame()) break;
+            Events::drainInbox();
+            Events::pollEvent<TickEvent>();     // same order as Context::run
+            Events::pollEvents();
+            stats.m_frameTimes.push_back(Profile::now() - start);
+        }
+
+        stats.m_frames = static_cast<uint32_t>(stats.m_frameTimes.size());
+        if(stats.m_frames == 0) return stats;
+
+        std::vector<double> sorted = stats.m_frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        for(double time : sorted) {
+            stats.m_total += time;
+        }
+        stats.m_mean = stats.m_total / stats.m_frames;
+        stats.m_min = sorted.front();
+        stats.m_max = sorted.back();
+        stats.m_p50 = percentile(sorted, 0.50);
+        stats.m_p95 = percentile(sorted, 0.95);
+        stats.m_p99 = percentile(sorted, 0.99);
+
+        return stats;
+    }
+
+    // explicitly state which template specializations should be created.
+#   define EXPLICIT_TEMPLATE_RECORD(T) template void record<T ## Event>(const T ## Event&);
+    FOR_EACH_EVENT(EXPLICIT_TEMPLATE_RECORD)
+
+} // namespace Recorder
+} // namespace BIGGEngine
@@ -0,0 +1,66 @@
+//      Records the events coming from the context (input, window and Update/Tick events) into a
+//      binary file, and replays such a file through Events::setEvent without a window. Used to
+//      rerun the exact same session and compare frame times between builds.
+
+// File layout (native endianness, so only replay on the machine type it was recorded on):
+//      header:  char[4] "BGEV", uint16_t version, uint16_t number of event types
+//      records: uint8_t eventIndex<Event>, double timestamp (seconds since startRecording), payload
+// The payload is the event's members one after another, without padding. Strings are a uint32_t
+// length followed by the characters, DropPathEvent's paths a uint32_t count followed by the strings.
+// Events posted from other threads are recorded when Events::drainInbox() moves them to the queues.
+#pragma once
+
+#include "Events.hpp"
+
+#include <string>
+#include <vector>
+
+namespace BIGGEngine {
+namespace Recorder {
+
+    /// Starts writing every event passed to record() to @p path. Returns false if the file can't be
+    /// opened. Stops the previous recording if there is one.
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    bool isRecording();
+
+    /// Appends @p event to the recording. Does nothing if not recording.
+    template<typename Event>
+    void record(const Event& event);
+
+    /// Records @p event, then calls Events::setEvent with it. The context uses this instead of
+    /// Events::setEvent for every event which comes from outside the engine, unless it posts it.
+    template<typename Event>
+    void setEvent(Event&& event) {
+        if(isRecording()) record(event);
+        Events::setEvent<Event>(std::move(event));
+    }
+
+    /// Opens a recording for replay. Returns false if it can't be opened or has the wrong format.
+    bool openReplay(const std::string& path);
+    void closeReplay();
+
+    /// Feeds recorded events through Events::setEvent, up to and including the next UpdateEvent,
+    /// ie. one frame of the recorded session. Returns false once the recording is over.
+    bool replayFrame();
+
+    struct ReplayStats {
+        uint32_t m_frames = 0;
+        double m_total = 0.0;   // all times in seconds
+        double m_mean = 0.0;
+        double m_min = 0.0;
+        double m_max = 0.0;
+        double m_p50 = 0.0;
+        double m_p95 = 0.0;
+        double m_p99 = 0.0;
+        std::vector<double> m_frameTimes;
+    };
+
+    /// Replays the whole recording at @p path as fast as possible. Every frame is one replayFrame()
+    /// followed by Events::drainInbox(), pollEvent<TickEvent>() and pollEvents(), all of it timed.
+    /// No window needed.
+    /// Doesn't log the results, since logging is compiled out of the release builds worth comparing.
+    ReplayStats runReplay(const std::string& path);
+
+} // namespace Recorder
+} // namespace BIGGEngine
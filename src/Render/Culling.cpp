@@ -0,0 +1,147 @@
+#include "Culling.hpp"
+
+#include <glm/geometric.hpp>    // for glm::length()
+
+#if defined(__SSE__) || defined(_M_X64)
+#   include <xmmintrin.h>
+#   define BIGG_CULLING_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   include <arm_neon.h>
+#   define BIGG_CULLING_NEON 1
+#endif
+
+namespace BIGGEngine {
+namespace Culling {
+namespace {
+
+    constexpr uint32_t g_planeCount = 6;
+
+    bool isInside(const Frustum& frustum, float x, float y, float z, float radius) {
+        for(const glm::vec4& plane : frustum.m_planes) {
+            if(plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Appends first + i to @p visible for every bit i set in @p mask.
+    void appendVisible(uint32_t mask, uint32_t first, std::vector<uint32_t>& visible) {
+        for(uint32_t i = 0; i < 4; i++) {
+            if(mask & (1u << i)) {
+                visible.push_back(first + i);
+            }
+        }
+    }
+
+}   // anonymous namespace
+
+    Frustum getFrustum(const glm::mat4& viewProjection) {
+        // rows of the matrix (glm is column major). A point is inside if -w <= x, y, z <= w in
+        // clip space, which is also right (if a little generous at the near plane) for a 0 to 1 depth range.
+        glm::vec4 rows[4];
+        for(int i = 0; i < 4; i++) {
+            rows[i] = {viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]};
+        }
+        Frustum frustum{{
+                rows[3] + rows[0], rows[3] - rows[0],
+                rows[3] + rows[1], rows[3] - rows[1],
+                rows[3] + rows[2], rows[3] - rows[2],
+        }};
+        for(glm::vec4& plane : frustum.m_planes) {
+            plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+        }
+        return frustum;
+    }
+
+    void Spheres::clear() {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+        m_radius.clear();
+    }
+
+    void Spheres::push_back(const glm::vec3& center, float radius) {
+        m_x.push_back(center.x);
+        m_y.push_back(center.y);
+        m_z.push_back(center.z);
+        m_radius.push_back(radius);
+    }
+
+    void Spheres::resize(uint32_t count) {
+        m_x.resize(count);
+        m_y.resize(count);
+        m_z.resize(count);
+        m_radius.resize(count);
+    }
+
+    void Spheres::set(uint32_t index, const glm::vec3& center, float radius) {
+        m_x[index] = center.x;
+        m_y[index] = center.y;
+        m_z[index] = center.z;
+        m_radius[index] = radius;
+    }
+
+    void cull(const Frustum& frustum, const Spheres& spheres, std::vector<uint32_t>& visible) {
+        visible.clear();
+        const uint32_t count = spheres.size();
+        uint32_t first = 0;
+
+#if BIGG_CULLING_SSE
+        __m128 planeX[g_planeCount], planeY[g_planeCount], planeZ[g_planeCount], planeW[g_planeCount];
+        for(uint32_t i = 0; i < g_planeCount; i++) {
+            planeX[i] = _mm_set1_ps(frustum.m_planes[i].x);
+            planeY[i] = _mm_set1_ps(frustum.m_planes[i].y);
+            planeZ[i] = _mm_set1_ps(frustum.m_planes[i].z);
+            planeW[i] = _mm_set1_ps(frustum.m_planes[i].w);
+        }
+        for(; first + 4 <= count; first += 4) {
+            const __m128 x = _mm_loadu_ps(spheres.m_x.data() + first);
+            const __m128 y = _mm_loadu_ps(spheres.m_y.data() + first);
+            const __m128 z = _mm_loadu_ps(spheres.m_z.data() + first);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.m_radius.data() + first));
+
+            __m128 inside = _mm_cmpeq_ps(negativeRadius, negativeRadius);  // all set
+            for(uint32_t i = 0; i < g_planeCount; i++) {
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[i]), _mm_mul_ps(y, planeY[i])),
+                                                   _mm_add_ps(_mm_mul_ps(z, planeZ[i]), planeW[i]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            appendVisible(static_cast<uint32_t>(_mm_movemask_ps(inside)), first, visible);
+        }
+#elif BIGG_CULLING_NEON
+        float32x4_t planeX[g_planeCount], planeY[g_planeCount], planeZ[g_planeCount], planeW[g_planeCount];
+        for(uint32_t i = 0; i < g_planeCount; i++) {
+            planeX[i] = vdupq_n_f32(frustum.m_planes[i].x);
+            planeY[i] = vdupq_n_f32(frustum.m_planes[i].y);
+            planeZ[i] = vdupq_n_f32(frustum.m_planes[i].z);
+            planeW[i] = vdupq_n_f32(frustum.m_planes[i].w);
+        }
+        const uint32_t lanes[4] = {1, 2, 4, 8};
+        const uint32x4_t laneBits = vld1q_u32(lanes);
+        for(; first + 4 <= count; first += 4) {
+            const float32x4_t x = vld1q_f32(spheres.m_x.data() + first);
+            const float32x4_t y = vld1q_f32(spheres.m_y.data() + first);
+            const float32x4_t z = vld1q_f32(spheres.m_z.data() + first);
+            const float32x4_t negativeRadius = vnegq_f32(vld1q_f32(spheres.m_radius.data() + first));
+
+            uint32x4_t inside = vdupq_n_u32(~0u);
+            for(uint32_t i = 0; i < g_planeCount; i++) {
+                float32x4_t distance = vmlaq_f32(planeW[i], x, planeX[i]);
+                distance = vmlaq_f32(distance, y, planeY[i]);
+                distance = vmlaq_f32(distance, z, planeZ[i]);
+                inside = vandq_u32(inside, vcgeq_f32(distance, negativeRadius));
+            }
+            appendVisible(vaddvq_u32(vandq_u32(inside, laneBits)), first, visible);
+        }
+#endif
+        // the rest, or everything without SIMD
+        for(; first < count; first++) {
+            if(isInside(frustum, spheres.m_x[first], spheres.m_y[first], spheres.m_z[first], spheres.m_radius[first])) {
+                visible.push_back(first);
+            }
+        }
+    }
+
+} // namespace Culling
+} // namespace BIGGEngine
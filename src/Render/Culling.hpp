@@ -0,0 +1,43 @@
+//      Frustum culling of bounding spheres, four at a time.
+
+// Spheres are kept as separate arrays of x, y, z and radius, so one SIMD register holds the same
+// coordinate of four spheres and each frustum plane is tested against four of them with a few
+// instructions. SSE on x86, NEON on ARM (Apple silicon), plain C++ otherwise.
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+namespace BIGGEngine {
+namespace Culling {
+
+    /// Six planes (left, right, bottom, top, near, far) facing inwards, normalized so a point's
+    /// signed distance is dot(plane.xyz, point) + plane.w.
+    struct Frustum {
+        glm::vec4 m_planes[6];
+    };
+    /// The frustum of a projection times view matrix.
+    Frustum getFrustum(const glm::mat4& viewProjection);
+
+    /// World space bounding spheres, in structure of arrays layout.
+    struct Spheres {
+        std::vector<float> m_x, m_y, m_z, m_radius;
+
+        void clear();
+        void push_back(const glm::vec3& center, float radius);
+        void resize(uint32_t count);
+        /// Overwrites sphere @p index, which resize() made room for. Threads may set different spheres at once.
+        void set(uint32_t index, const glm::vec3& center, float radius);
+        uint32_t size() const { return static_cast<uint32_t>(m_radius.size()); }
+    };
+
+    /// Fills @p visible with the indices of the @p spheres which are at least partly inside
+    /// @p frustum, in increasing order.
+    void cull(const Frustum& frustum, const Spheres& spheres, std::vector<uint32_t>& visible);
+
+} // namespace Culling
+} // namespace BIGGEngine
@@ -0,0 +1,237 @@
+#include "MeshLoader.hpp"
+
+#include "../Core.hpp"
+#include "MeshRegistry.hpp"
+
+#include <fcntl.h>      // for open()
+#include <sys/mman.h>   // for mmap()
+#include <sys/stat.h>   // for fstat()
+#include <unistd.h>     // for close()
+
+#include <atomic>
+#include <cstring>      // for std::memcpy
+#include <vector>
+
+namespace BIGGEngine {
+namespace MeshLoader {
+namespace {
+
+    constexpr uint32_t makeChunk(char a, char b, char c, uint8_t version) {
+        return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(version) << 24;
+    }
+    constexpr uint32_t g_chunkVertexBuffer = makeChunk('V', 'B', ' ', 1);
+    constexpr uint32_t g_chunkVertexBufferCompressed = makeChunk('V', 'B', 'C', 0);
+    constexpr uint32_t g_chunkIndexBuffer = makeChunk('I', 'B', ' ', 0);
+    constexpr uint32_t g_chunkIndexBufferCompressed = makeChunk('I', 'B', 'C', 1);
+    constexpr uint32_t g_chunkPrimitive = makeChunk('P', 'R', 'I', 0);
+
+    constexpr uint32_t g_boundsSize = 16 + 24 + 64;  // sphere, aabb and obb, which aren't used
+
+    /// A read-only mapping of a whole file, which unmaps itself when the last of its references is released.
+    struct MappedFile {
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        std::atomic<uint32_t> m_references{0};
+    };
+
+    MappedFile* map(const char* filepath) {
+        const int fd = open(filepath, O_RDONLY);
+        if(fd < 0) {
+            BIGG_LOG_WARN("Couldn't open mesh '{:s}'!", filepath);
+            return nullptr;
+        }
+        struct stat info;
+        void* data = MAP_FAILED;
+        if(fstat(fd, &info) == 0 && info.st_size > 0) {
+            data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);  // the mapping stays valid
+        if(data == MAP_FAILED) {
+            BIGG_LOG_WARN("Couldn't map mesh '{:s}'!", filepath);
+            return nullptr;
+        }
+        MappedFile* file = new MappedFile;
+        file->m_data = static_cast<const uint8_t*>(data);
+        file->m_size = static_cast<size_t>(info.st_size);
+        return file;
+    }
+
+    void unmap(MappedFile* file) {
+        munmap(const_cast<uint8_t*>(file->m_data), file->m_size);
+        delete file;
+    }
+
+    /// bgfx::ReleaseFn for every block of the file given to the MeshRegistry. Called on bgfx's render thread.
+    void release(void* data, void* userData) {
+        MappedFile* file = static_cast<MappedFile*>(userData);
+        if(file->m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            unmap(file);
+        }
+    }
+
+    /// Reads the mapped file front to back, failing (and staying failed) when it would read past the end.
+    struct Reader {
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_position = 0;
+        bool m_failed = false;
+
+        /// Returns @p size bytes in place and moves past them, nullptr if there aren't that many left.
+        const uint8_t* skip(size_t size) {
+            if(m_failed || m_size - m_position < size) {
+                m_failed = true;
+                return nullptr;
+            }
+            const uint8_t* data = m_data + m_position;
+            m_position += size;
+            return data;
+        }
+
+        /// Values are unaligned in the file, so they are copied out.
+        template<typename T>
+        T read() {
+            T value{};
+            if(const uint8_t* data = skip(sizeof(T))) {
+                std::memcpy(&value, data, sizeof(T));
+            }
+            return value;
+        }
+
+        bool atEnd() const {
+            return m_failed || m_position == m_size;
+        }
+    };
+
+    bgfx::Attrib::Enum getAttrib(uint16_t id) {
+        switch(id) {
+            case 0x01: return bgfx::Attrib::Position;
+            case 0x02: return bgfx::Attrib::Normal;
+            case 0x03: return bgfx::Attrib::Tangent;
+            case 0x04: return bgfx::Attrib::Bitangent;
+            case 0x05: return bgfx::Attrib::Color0;
+            case 0x06: return bgfx::Attrib::Color1;
+            case 0x18: return bgfx::Attrib::Color2;
+            case 0x19: return bgfx::Attrib::Color3;
+            case 0x0e: return bgfx::Attrib::Indices;
+            case 0x0f: return bgfx::Attrib::Weight;
+            case 0x10: return bgfx::Attrib::TexCoord0;
+            case 0x11: return bgfx::Attrib::TexCoord1;
+            case 0x12: return bgfx::Attrib::TexCoord2;
+            case 0x13: return bgfx::Attrib::TexCoord3;
+            case 0x14: return bgfx::Attrib::TexCoord4;
+            case 0x15: return bgfx::Attrib::TexCoord5;
+            case 0x16: return bgfx::Attrib::TexCoord6;
+            case 0x17: return bgfx::Attrib::TexCoord7;
+            default:   return bgfx::Attrib::Count;
+        }
+    }
+
+    bgfx::AttribType::Enum getAttribType(uint16_t id) {
+        switch(id) {
+            case 0x01: return bgfx::AttribType::Uint8;
+            case 0x02: return bgfx::AttribType::Int16;
+            case 0x03: return bgfx::AttribType::Half;
+            case 0x04: return bgfx::AttribType::Float;
+            case 0x05: return bgfx::AttribType::Uint10;
+            default:   return bgfx::AttribType::Count;
+        }
+    }
+
+    /// The layout as bgfx::read(VertexLayout) would, keeping the file's offsets and stride.
+    /// Attributes this version of bgfx doesn't know are skipped.
+    bgfx::VertexLayout readLayout(Reader& reader) {
+        bgfx::VertexLayout layout;
+        const uint8_t attributeCount = reader.read<uint8_t>();
+        const uint16_t stride = reader.read<uint16_t>();
+        layout.begin();
+        for(uint8_t i = 0; i < attributeCount && !reader.m_failed; i++) {
+            const uint16_t offset = reader.read<uint16_t>();
+            const bgfx::Attrib::Enum attrib = getAttrib(reader.read<uint16_t>());
+            const uint8_t num = reader.read<uint8_t>();
+            const bgfx::AttribType::Enum type = getAttribType(reader.read<uint16_t>());
+            const bool normalized = reader.read<bool>();
+            const bool asInt = reader.read<bool>();
+            if(attrib != bgfx::Attrib::Count && type != bgfx::AttribType::Count) {
+                layout.add(attrib, num, type, normalized, asInt);
+                layout.m_offset[attrib] = offset;
+            }
+        }
+        layout.end();
+        layout.m_stride = stride;
+        return layout;
+    }
+
+    /// Points @p parts into the file, one per group of a vertex and an index chunk.
+    bool parse(Reader& reader, const char* filepath, std::vector<MeshRegistry::Part>& parts) {
+        MeshRegistry::Part part;
+        while(!reader.atEnd()) {
+            const uint32_t chunk = reader.read<uint32_t>();
+            if(chunk == g_chunkVertexBuffer) {
+                reader.skip(g_boundsSize);
+                part.m_layout = readLayout(reader);
+                const uint16_t vertexCount = reader.read<uint16_t>();
+                part.m_verticesSize = vertexCount * part.m_layout.getStride();
+                part.m_vertices = reader.skip(part.m_verticesSize);
+            } else if(chunk == g_chunkIndexBuffer) {
+                const uint32_t indexCount = reader.read<uint32_t>();
+                part.m_indicesSize = indexCount * sizeof(uint16_t);
+                part.m_indices = reader.skip(part.m_indicesSize);
+                if(!part.m_vertices) {
+                    BIGG_LOG_WARN("Mesh '{:s}' has indices before vertices!", filepath);
+                    return false;
+                }
+                parts.push_back(part);
+                part = MeshRegistry::Part{};
+            } else if(chunk == g_chunkPrimitive) {
+                reader.skip(reader.read<uint16_t>());   // material name
+                const uint16_t primitiveCount = reader.read<uint16_t>();
+                for(uint16_t i = 0; i < primitiveCount && !reader.m_failed; i++) {
+                    reader.skip(reader.read<uint16_t>());   // name
+                    reader.skip(4 * sizeof(uint32_t) + g_boundsSize);
+                }
+            } else if(chunk == g_chunkVertexBufferCompressed || chunk == g_chunkIndexBufferCompressed) {
+                BIGG_LOG_WARN("Mesh '{:s}' is compressed, build it with geometryc without --compress!", filepath);
+                return false;
+            } else {
+                BIGG_LOG_WARN("Mesh '{:s}' has an unknown chunk {:#010x}!", filepath, chunk);
+                return false;
+            }
+        }
+        if(reader.m_failed) {
+            BIGG_LOG_WARN("Mesh '{:s}' is truncated!", filepath);
+            return false;
+        }
+        if(parts.empty()) {
+            BIGG_LOG_WARN("Mesh '{:s}' has no geometry!", filepath);
+            return false;
+        }
+        return true;
+    }
+
+}   // anonymous namespace
+
+    bool load(entt::hashed_string name, const char* filepath) {
+        BIGG_PROFILE_INIT_FUNCTION;
+
+        MappedFile* file = map(filepath);
+        if(!file) {
+            return false;
+        }
+        Reader reader{file->m_data, file->m_size};
+        std::vector<MeshRegistry::Part> parts;
+        if(!parse(reader, filepath, parts)) {
+            unmap(file);
+            return false;
+        }
+
+        // one reference for every vertex and index block, which bgfx releases separately.
+        file->m_references = 2 * static_cast<uint32_t>(parts.size());
+        if(!MeshRegistry::addReference(name, parts.data(), static_cast<uint32_t>(parts.size()), release, file)) {
+            unmap(file);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace MeshLoader
+} // namespace BIGGEngine
@@ -0,0 +1,20 @@
+//      Loads meshes from geometryc's binary format (eg. res/models/testbunny.bin) into the MeshRegistry.
+
+// The file is memory mapped and parsed in place: the vertex and index data is handed to bgfx
+// with bgfx::makeRef, straight out of the mapping, and the file is unmapped once bgfx has released
+// all of it. So loading a large model doesn't copy it into the heap first.
+// Every group in the file becomes one part of the mesh. Primitives, bounds and materials are
+// skipped, and compressed (meshoptimizer) vertices or indices aren't supported.
+#pragma once
+
+#include <entt/core/hashed_string.hpp>
+
+namespace BIGGEngine {
+namespace MeshLoader {
+
+    /// Adds the geometry at @p filepath to the MeshRegistry as @p name. Returns false (and logs
+    /// why) if the file can't be read or parsed, or the name is taken.
+    bool load(entt::hashed_string name, const char* filepath);
+
+} // namespace MeshLoader
+} // namespace BIGGEngine
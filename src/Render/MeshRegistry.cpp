@@ -0,0 +1,298 @@
+#include "MeshRegistry.hpp"
+
+#include "../Core.hpp"
+
+#include <glm/common.hpp>      // for glm::min(), glm::max()
+#include <glm/geometric.hpp>   // for glm::length()
+
+#include <algorithm>
+#include <cstring>  // for std::memcpy
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace BIGGEngine {
+namespace MeshRegistry {
+namespace {
+
+    struct MeshAsset {
+        std::vector<Part> m_parts;          // data pointers are cleared once the buffers are created
+        std::vector<Buffers> m_buffers;     // one per part
+        Bounds m_bounds;
+        std::vector<uint8_t> m_storage;     // the copies add() made, the parts point into it
+        bgfx::ReleaseFn m_release = nullptr;    // set by addReference()
+        void* m_userData = nullptr;
+        uint32_t m_references = 0;
+        bool m_added = false;               // add() holds a reference until remove()
+    };
+
+    std::unordered_map<MeshId, MeshAsset> meshes;
+
+    struct CubeVertex {
+        float x, y, z;
+        uint32_t colour;
+    };
+
+    constexpr CubeVertex g_cubeVertices[] = {
+            {-1.0f,  1.0f,  1.0f, 0xff000000 },
+            { 1.0f,  1.0f,  1.0f, 0xff0000ff },
+            {-1.0f, -1.0f,  1.0f, 0xff00ff00 },
+            { 1.0f, -1.0f,  1.0f, 0xff00ffff },
+            {-1.0f,  1.0f, -1.0f, 0xffff0000 },
+            { 1.0f,  1.0f, -1.0f, 0xffff00ff },
+            {-1.0f, -1.0f, -1.0f, 0xffffff00 },
+            { 1.0f, -1.0f, -1.0f, 0xffffffff },
+    };
+    constexpr uint16_t g_cubeIndices[] = {
+            0, 1, 2,
+            1, 3, 2,
+            4, 6, 5,
+            5, 6, 7,
+            0, 2, 4,
+            4, 2, 6,
+            1, 5, 3,
+            5, 7, 3,
+            0, 4, 1,
+            4, 5, 1,
+            2, 3, 6,
+            6, 3, 7,
+    };
+
+    /// Destroys the buffers, or hands data which was never uploaded back to its owner.
+    void destroyBuffers(MeshAsset& mesh) {
+        for(uint32_t i = 0; i < mesh.m_parts.size(); i++) {
+            Part& part = mesh.m_parts[i];
+            Buffers& buffers = mesh.m_buffers[i];
+            if(bgfx::isValid(buffers.m_vertexBuffer)) {
+                bgfx::destroy(buffers.m_vertexBuffer);
+            } else if(mesh.m_release && part.m_vertices) {
+                mesh.m_release(const_cast<void*>(part.m_vertices), mesh.m_userData);
+            }
+            if(bgfx::isValid(buffers.m_indexBuffer)) {
+                bgfx::destroy(buffers.m_indexBuffer);
+            } else if(mesh.m_release && part.m_indices) {
+                mesh.m_release(const_cast<void*>(part.m_indices), mesh.m_userData);
+            }
+            part.m_vertices = part.m_indices = nullptr;
+            buffers = Buffers{};
+        }
+    }
+
+    /// Memory for @p size bytes at @p data, referenced instead of copied if the mesh was added with addReference().
+    const bgfx::Memory* getMemory(const MeshAsset& mesh, const void* data, uint32_t size) {
+        return mesh.m_release ? bgfx::makeRef(data, size, mesh.m_release, mesh.m_userData) : bgfx::copy(data, size);
+    }
+
+    /// A sphere around the positions of every part: centred on their bounding box, which is close
+    /// enough to the smallest sphere for culling.
+    Bounds computeBounds(const Part* parts, uint32_t count) {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{-std::numeric_limits<float>::max()};
+        for(uint32_t i = 0; i < count; i++) {
+            const Part& part = parts[i];
+            if(!part.m_layout.has(bgfx::Attrib::Position) || part.m_layout.getStride() == 0) continue;
+            const uint32_t vertexCount = part.m_verticesSize / part.m_layout.getStride();
+            for(uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+                float position[4];
+                bgfx::vertexUnpack(position, bgfx::Attrib::Position, part.m_layout, part.m_vertices, vertex);
+                min = glm::min(min, glm::vec3{position[0], position[1], position[2]});
+                max = glm::max(max, glm::vec3{position[0], position[1], position[2]});
+            }
+        }
+        if(min.x > max.x) {
+            return {};  // no positions
+        }
+        Bounds bounds{(min + max) * 0.5f, 0.0f};
+        for(uint32_t i = 0; i < count; i++) {
+            const Part& part = parts[i];
+            if(!part.m_layout.has(bgfx::Attrib::Position) || part.m_layout.getStride() == 0) continue;
+            const uint32_t vertexCount = part.m_verticesSize / part.m_layout.getStride();
+            for(uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+                float position[4];
+                bgfx::vertexUnpack(position, bgfx::Attrib::Position, part.m_layout, part.m_vertices, vertex);
+                bounds.m_radius = std::max(bounds.m_radius, glm::length(glm::vec3{position[0], position[1], position[2]} - bounds.m_center));
+            }
+        }
+        return bounds;
+    }
+
+    MeshAsset* insert(entt::hashed_string name, const Part* parts, uint32_t count) {
+        BIGG_ASSERT(count > 0, "Mesh '{:s}' has no parts!", name.data());
+        auto [it, inserted] = meshes.try_emplace(name.value());
+        if(!inserted) {
+            BIGG_LOG_WARN("A mesh named '{:s}' already exists!", name.data());
+            return nullptr;
+        }
+        MeshAsset& mesh = it->second;
+        mesh.m_parts.assign(parts, parts + count);
+        mesh.m_buffers.resize(count);
+        mesh.m_bounds = computeBounds(parts, count);
+        mesh.m_references = 1;
+        mesh.m_added = true;
+        return &mesh;
+    }
+
+    void acquire(MeshId id) {
+        auto it = meshes.find(id);
+        BIGG_ASSERT(it != meshes.end(), "A Mesh component uses mesh {:d}, which wasn't added!", id);
+        if(it != meshes.end()) {
+            it->second.m_references++;
+        }
+    }
+
+    void release(MeshId id) {
+        auto it = meshes.find(id);
+        if(it == meshes.end()) return;  // eg. after shutdown()
+        BIGG_ASSERT(it->second.m_references > 0, "Mesh {:d} was released more often than acquired!", id);
+        if(--it->second.m_references == 0) {
+            destroyBuffers(it->second);
+            meshes.erase(it);
+        }
+    }
+
+    /// The mesh an entity's Mesh component holds a reference on. By the time on_update fires, the
+    /// Mesh already has the new id, so the old one is kept here.
+    struct MeshReference {
+        MeshId m_id;
+    };
+
+    void onMeshConstruct(entt::registry& registry, entt::entity entity) {
+        const MeshId id = registry.get<Mesh>(entity).m_id;
+        acquire(id);
+        registry.emplace_or_replace<MeshReference>(entity, id);
+        if(!registry.try_get<Bounds>(entity)) {
+            registry.emplace<Bounds>(entity, getBounds(id));
+        }
+    }
+
+    /// replace() or patch(). Moves the reference to the new mesh and takes its bounds.
+    void onMeshUpdate(entt::registry& registry, entt::entity entity) {
+        const MeshId id = registry.get<Mesh>(entity).m_id;
+        MeshReference& reference = registry.get<MeshReference>(entity);
+        if(reference.m_id == id) {
+            return;
+        }
+        acquire(id);
+        release(reference.m_id);
+        reference.m_id = id;
+        registry.emplace_or_replace<Bounds>(entity, getBounds(id));
+    }
+
+    void onMeshDestroy(entt::registry& registry, entt::entity entity) {
+        release(registry.get<MeshReference>(entity).m_id);
+    }
+
+}   // anonymous namespace
+
+    void init() {
+        BIGG_PROFILE_INIT_FUNCTION;
+
+        bgfx::VertexLayout layout;
+        layout.begin()
+                .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+                .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+                .end();
+        add(entt::hashed_string{"cube"}, layout, g_cubeVertices, sizeof(g_cubeVertices), g_cubeIndices, sizeof(g_cubeIndices));
+
+        entt::registry& registry = ECS::get();
+        registry.on_construct<Mesh>().connect<&onMeshConstruct>();
+        registry.on_update<Mesh>().connect<&onMeshUpdate>();
+        registry.on_destroy<Mesh>().connect<&onMeshDestroy>();
+    }
+
+    void shutdown() {
+        BIGG_PROFILE_SHUTDOWN_FUNCTION;
+        entt::registry& registry = ECS::get();
+        registry.on_construct<Mesh>().disconnect<&onMeshConstruct>();
+        registry.on_update<Mesh>().disconnect<&onMeshUpdate>();
+        registry.on_destroy<Mesh>().disconnect<&onMeshDestroy>();
+
+        for(auto& [id, mesh] : meshes) {
+            destroyBuffers(mesh);
+        }
+        meshes.clear();
+    }
+
+    bool add(entt::hashed_string name, const bgfx::VertexLayout& layout, const void* vertices, uint32_t verticesSize,
+             const void* indices, uint32_t indicesSize, bool index32) {
+        const Part part{layout, vertices, verticesSize, indices, indicesSize, index32};
+        return add(name, &part, 1);
+    }
+
+    bool add(entt::hashed_string name, const Part* parts, uint32_t count) {
+        MeshAsset* mesh = insert(name, parts, count);
+        if(!mesh) {
+            return false;
+        }
+        size_t size = 0;
+        for(const Part& part : mesh->m_parts) {
+            size += part.m_verticesSize + part.m_indicesSize;
+        }
+        mesh->m_storage.resize(size);
+        uint8_t* storage = mesh->m_storage.data();
+        for(Part& part : mesh->m_parts) {
+            std::memcpy(storage, part.m_vertices, part.m_verticesSize);
+            part.m_vertices = storage;
+            storage += part.m_verticesSize;
+            std::memcpy(storage, part.m_indices, part.m_indicesSize);
+            part.m_indices = storage;
+            storage += part.m_indicesSize;
+        }
+        return true;
+    }
+
+    bool addReference(entt::hashed_string name, const Part* parts, uint32_t count, bgfx::ReleaseFn release, void* userData) {
+        BIGG_ASSERT(release, "Mesh '{:s}' can't be released!", name.data());
+        MeshAsset* mesh = insert(name, parts, count);
+        if(!mesh) {
+            return false;
+        }
+        mesh->m_release = release;
+        mesh->m_userData = userData;
+        return true;
+    }
+
+    void remove(MeshId id) {
+        auto it = meshes.find(id);
+        if(it == meshes.end() || !it->second.m_added) return;
+        it->second.m_added = false;
+        release(id);
+    }
+
+    bool exists(MeshId id) {
+        return meshes.find(id) != meshes.end();
+    }
+
+    uint32_t getReferenceCount(MeshId id) {
+        auto it = meshes.find(id);
+        return it != meshes.end() ? it->second.m_references : 0;
+    }
+
+    Bounds getBounds(MeshId id) {
+        auto it = meshes.find(id);
+        return it != meshes.end() ? it->second.m_bounds : Bounds{};
+    }
+
+    const std::vector<Buffers>& getBuffers(MeshId id) {
+        static const std::vector<Buffers> none;
+        auto it = meshes.find(id);
+        if(it == meshes.end()) {
+            return none;
+        }
+        MeshAsset& mesh = it->second;
+        if(!bgfx::isValid(mesh.m_buffers.front().m_vertexBuffer)) {
+            for(uint32_t i = 0; i < mesh.m_parts.size(); i++) {
+                Part& part = mesh.m_parts[i];
+                Buffers& buffers = mesh.m_buffers[i];
+                buffers.m_vertexBuffer = bgfx::createVertexBuffer(getMemory(mesh, part.m_vertices, part.m_verticesSize), part.m_layout);
+                buffers.m_indexBuffer = bgfx::createIndexBuffer(getMemory(mesh, part.m_indices, part.m_indicesSize),
+                                                                part.m_index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
+                part.m_vertices = part.m_indices = nullptr;   // bgfx owns (or has copied) them now
+            }
+            mesh.m_storage = {};
+        }
+        return mesh.m_buffers;
+    }
+
+} // namespace MeshRegistry
+} // namespace BIGGEngine
@@ -0,0 +1,70 @@
+//      Shared mesh assets. Geometry is registered once under a name and drawn by any number of
+//      entities, whose Mesh component only holds the name's hash.
+
+// Every mesh is reference counted: add() holds one reference until remove(), and every Mesh
+// component holds one while it exists (through the registry's on_construct / on_update / on_destroy
+// signals, so replacing a Mesh moves its reference to the new mesh).
+// The vertex and index buffers are created the first time the mesh is drawn, so meshes can be
+// added before bgfx is initialized, and destroyed once the last reference is gone.
+// A mesh is made of one or more parts, each with its own buffers, eg. because a model has more
+// vertices than 16 bit indices can address. Every part is drawn with the same transform.
+#pragma once
+
+#include "../Components.hpp"    // for MeshId and Bounds
+
+#include <bgfx/bgfx.h>
+#include <entt/core/hashed_string.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+namespace BIGGEngine {
+namespace MeshRegistry {
+
+    /// Adds the built-in "cube" and starts counting Mesh components. Called by RenderMeshComponents::init(),
+    /// which has to come before creating entities with a Mesh.
+    void init();
+    /// Destroys every mesh and its buffers. bgfx must still be initialized.
+    void shutdown();
+
+    /// Vertices in @p m_layout and 16 bit (or @p m_index32 32 bit) indices of one part of a mesh.
+    struct Part {
+        bgfx::VertexLayout m_layout;
+        const void* m_vertices = nullptr;
+        uint32_t m_verticesSize = 0;
+        const void* m_indices = nullptr;
+        uint32_t m_indicesSize = 0;
+        bool m_index32 = false;
+    };
+
+    /// Registers @p name with a copy of @p vertices in @p layout and 16 bit (or @p index32 32 bit)
+    /// @p indices. Returns false if the name is taken.
+    bool add(entt::hashed_string name, const bgfx::VertexLayout& layout, const void* vertices, uint32_t verticesSize,
+             const void* indices, uint32_t indicesSize, bool index32 = false);
+    /// Registers @p name with a copy of @p count @p parts. Returns false if the name is taken.
+    bool add(entt::hashed_string name, const Part* parts, uint32_t count);
+    /// Registers @p name without copying the parts' data, which has to stay valid until
+    /// @p release(data, @p userData) was called for it: once for every part's vertices and once for
+    /// its indices, when bgfx is done uploading them (on its render thread, if there is one) or when
+    /// the mesh goes away before being drawn. Returns false, and releases nothing, if the name is taken.
+    bool addReference(entt::hashed_string name, const Part* parts, uint32_t count, bgfx::ReleaseFn release, void* userData);
+
+    /// Drops the reference add() took. The mesh goes away once no Mesh component uses it either.
+    void remove(MeshId id);
+
+    bool exists(MeshId id);
+    uint32_t getReferenceCount(MeshId id);
+
+    /// Sphere around the mesh's positions, computed when it was added. Empty if there is no mesh @p id.
+    Bounds getBounds(MeshId id);
+
+    struct Buffers {
+        bgfx::VertexBufferHandle m_vertexBuffer = BGFX_INVALID_HANDLE;
+        bgfx::IndexBufferHandle m_indexBuffer = BGFX_INVALID_HANDLE;
+    };
+    /// The buffers of each of the mesh's parts, created now if this is the first time it is drawn.
+    /// Empty if there is no mesh @p id. On bgfx's API thread.
+    const std::vector<Buffers>& getBuffers(MeshId id);
+
+} // namespace MeshRegistry
+} // namespace BIGGEngine
@@ -1,6 +1,7 @@
 #include "RenderBase.hpp"
 #include "../Core.hpp"
 #include "../Context.hpp"
+#include "../Latency.hpp"
 #include <glm/vec2.hpp>
 
 #include <bgfx/bgfx.h>
@@ -14,8 +15,9 @@ namespace RenderBase {
 namespace {
 
     uint32_t resetFlags = BGFX_RESET_VSYNC | BGFX_RESET_MSAA_X16;
+    bgfx::RendererType::Enum rendererType = bgfx::RendererType::Count;   // Count lets bgfx choose
 
-    bool handleWindowCreateEvent(WindowCreateEvent){
+    bool handleWindowCreateEvent(const WindowCreateEvent&){
         BIGG_PROFILE_RENDERER_FUNCTION;
 
         bgfx::PlatformData pd;
@@ -35,35 +37,37 @@ namespace {
         // These things could be determined by bgfx if I just leave them uninitialized
         init.resolution.reset = resetFlags;
 //        init.vendorId = BGFX_PCI_ID_APPLE;
-//        init.type = bgfx::RendererType::Metal;
+        init.type = rendererType;
         bgfx::init(init);
-
-        // TODO macro/loop for each view
-        bgfx::setViewClear(0, BGFX_CLEAR_COLOR|BGFX_CLEAR_DEPTH, 0x939762ff);
-        bgfx::setViewRect(0, 0, 0, fbSize.x, fbSize.y);
-        bgfx::setViewRect(1, 0, 0, fbSize.x, fbSize.y);
-        bgfx::setViewRect(2, 0, 0, fbSize.x, fbSize.y);
+        // every Camera sets its view's rect and clear each frame, RenderUI the rect of g_uiViewID
 
         return false;
     }
-    bool handleWindowSizeEvent(WindowSizeEvent event) {
+    bool handleWindowSizeEvent(const WindowSizeEvent& event) {
         bgfx::reset((uint32_t)event.m_size.x, (uint32_t)event.m_size.y, resetFlags);
-
-        // TODO macro/loop for each view
-        bgfx::setViewRect(0, 0, 0, uint16_t(event.m_size.x), uint16_t(event.m_size.y));
-        bgfx::setViewRect(1, 0, 0, uint16_t(event.m_size.x), uint16_t(event.m_size.y));
-        bgfx::setViewRect(2, 0, 0, uint16_t(event.m_size.x), uint16_t(event.m_size.y));
         return false;
     }
-    bool handleLateUpdateEvent(UpdateEvent) {
+    bool handleLateUpdateEvent(const UpdateEvent&) {
         BIGG_PROFILE_RENDERER_FUNCTION;
+        if(!Context::shouldDraw()) {
+            return false;
+        }
         bgfx::frame();
+        Latency::mark(Latency::Stage::Frame);
         return false;
     }
 }
-    void init() {
+    void init(bool headless, bool renderThread) {
         BIGG_PROFILE_INIT_FUNCTION;
 
+        rendererType = headless ? bgfx::RendererType::Noop : bgfx::RendererType::Count;
+        if(renderThread) {
+            // Calling renderFrame before bgfx::init makes this the render thread, and whichever thread
+            // calls bgfx::init (handleWindowCreateEvent) the API thread.
+            bgfx::renderFrame();
+            Context::setRenderThread([]() { bgfx::renderFrame(g_renderThreadWait); });
+        }
+
         Events::subscribe<WindowCreateEvent>(g_renderBaseBeginPriority, handleWindowCreateEvent);
         Events::subscribe<WindowSizeEvent>(g_renderBaseBeginPriority,   handleWindowSizeEvent);
         Events::subscribe<UpdateEvent>(g_renderBaseEndPriority,         handleLateUpdateEvent);
@@ -3,7 +3,10 @@
 namespace BIGGEngine {
 namespace RenderBase {
 
-    void init();
+    /// @p headless renders with bgfx's Noop renderer, which needs no window (see HeadlessContext).
+    /// @p renderThread puts bgfx into multithreaded mode: the main thread renders (see
+    /// Context::setRenderThread) and the engine thread becomes bgfx's API thread. Call on the main thread.
+    void init(bool headless = false, bool renderThread = false);
 
 } // namespace RenderBase
 } // namespace BIGGEngine
\ No newline at end of file
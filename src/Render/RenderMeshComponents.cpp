@@ -5,63 +5,247 @@
 #include "RenderMeshComponents.hpp"
 
 #include "../Context.hpp"
+#include "../Jobs.hpp"
+#include "../Latency.hpp"
+#include "Culling.hpp"
+#include "MeshRegistry.hpp"
 #include "RenderUtils.hpp"
 
+#include <glm/common.hpp>    // for glm::abs()
 #include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 #include <glm/gtc/matrix_transform.hpp> // for glm::ortho()
 #include <glm/gtc/type_ptr.hpp>         // for glm::value_ptr() (convert mat4 to float[16])
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
 namespace BIGGEngine {
 namespace RenderMeshComponents {
 namespace {
 
-    Mesh g_mesh;
-    bgfx::VertexLayout g_vertexLayout;
-    bgfx::VertexBufferHandle g_vertexBuffer;
-    bgfx::IndexBufferHandle g_indexBuffer;
     bgfx::ProgramHandle g_program;
+    bgfx::ProgramHandle g_instancedProgram = BGFX_INVALID_HANDLE;   // invalid if instancing isn't supported
+
+    /// Per instance data, in the layout vs_instancing reads as i_data0 to i_data4. It multiplies
+    /// the vertex colour by @c m_colour, which is white so instances look as vs_cubes draws them.
+    struct Instance {
+        glm::mat4 m_transform;
+        glm::vec4 m_colour{1.0f};
+    };
+    constexpr uint16_t g_instanceStride = sizeof(Instance);
+    static_assert(g_instanceStride == 80, "vs_instancing expects a 4x4 matrix and a colour per instance!");
+
+    bgfx::VertexLayout g_instanceLayout;    // of Instance, as i_data0 to i_data4
+    bgfx::DynamicVertexBufferHandle g_instanceBuffer = BGFX_INVALID_HANDLE;
+    uint32_t g_instanceBufferSize = 0;      // in instances
+
+    /// Every instance drawn this frame, of all views, uploaded to g_instanceBuffer at once.
+    std::vector<Instance> g_instances;
+
+    /// @c m_count instances of @c m_mesh from @c m_first in g_instances, drawn into view @c m_view.
+    struct Draw {
+        bgfx::ViewId m_view;
+        MeshId m_mesh;
+        uint32_t m_first;
+        uint32_t m_count;
+    };
+    std::vector<Draw> g_draws;
+
+    /// Every Mesh entity of this frame, whether or not a camera sees it.
+    struct Drawable {
+        MeshId m_mesh;
+        Instance m_instance;
+    };
+    std::vector<Drawable> g_drawables;
+    double counter = 0.0;               // seconds drawn, for the spinning
+    Culling::Spheres g_spheres;         // the drawables' world space bounds, in the same order
+    std::vector<uint32_t> g_visible;    // indices into g_drawables, of one view
+
+    /// Visible entities of one view which are drawn with the same mesh, which become one Draw.
+    struct DrawGroup {
+        MeshId m_mesh;
+        std::vector<Instance> m_instances;  // cleared, not freed, after every frame
+    };
+    std::vector<DrawGroup> g_groups;
+
+    DrawGroup& getGroup(MeshId mesh) {
+        for(DrawGroup& group : g_groups) {
+            if(group.m_mesh == mesh) {
+                return group;
+            }
+        }
+        return g_groups.emplace_back(DrawGroup{mesh, {}});
+    }
+
+    struct View {
+        bgfx::ViewId m_id;
+        Culling::Frustum m_frustum;
+    };
+    std::vector<View> g_views;     // of this frame's cameras
 
-    bool onWindowCreate(WindowCreateEvent e) {
-        g_vertexLayout.begin()
-                .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
-                .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-                .end();
+    /// Where @p entity is drawn this frame: in between the last two ticks, so movement is smooth at
+    /// any frame rate, then patched by its LateLatch.
+    Transform getDrawnTransform(entt::registry& registry, entt::entity entity, const Transform& current, float alpha) {
+        const PreviousTransform* previous = registry.try_get<PreviousTransform>(entity);
+        Transform transform = previous ? interpolate(previous->m_transform, current, alpha) : current;
+        if(LateLatch* latch = registry.try_get<LateLatch>(entity)) {
+            latch->m_function(entity, transform);
+        }
+        return transform;
+    }
+
+    /// Sets up @p camera's view once for the frame and adds it to g_views, unless its viewport is empty.
+    void setupView(const Camera& camera, const Transform& transform, glm::ivec2 framebufferSize) {
+        const uint16_t x = static_cast<uint16_t>(camera.m_viewport.x * framebufferSize.x);
+        const uint16_t y = static_cast<uint16_t>(camera.m_viewport.y * framebufferSize.y);
+        const uint16_t width = static_cast<uint16_t>(camera.m_viewport.z * framebufferSize.x);
+        const uint16_t height = static_cast<uint16_t>(camera.m_viewport.w * framebufferSize.y);
+        if(width == 0 || height == 0) {
+            return;
+        }
+        BIGG_ASSERT(camera.m_viewID < g_uiViewID, "Camera view {:d} would be drawn over the UI!", camera.m_viewID);
+
+        glm::mat4 view = glm::lookAtLH(transform.position, camera.m_target, camera.m_up);
+        glm::mat4 proj = glm::perspectiveLH(glm::radians(camera.m_fieldOfView), (float) width / (float) height, camera.m_near, camera.m_far);
+
+        bgfx::setViewRect(camera.m_viewID, x, y, width, height);
+        bgfx::setViewClear(camera.m_viewID, camera.m_clear ? BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH : BGFX_CLEAR_DEPTH, camera.m_clearColour);
+        bgfx::setViewTransform(camera.m_viewID, glm::value_ptr(view), glm::value_ptr(proj));
+        bgfx::touch(camera.m_viewID);   // clear it even if nothing is drawn
+        g_views.push_back({camera.m_viewID, Culling::getFrustum(proj * view)});
+    }
+
+    /// Sets sphere @p index to @p bounds moved into world space by @p transform, with the radius
+    /// grown by the largest scale.
+    void setWorldBounds(uint32_t index, const Bounds& bounds, const glm::mat4& transform, const glm::vec3& scale) {
+        const glm::vec3 center{transform * glm::vec4(bounds.m_center, 1.0f)};
+        const glm::vec3 absScale = glm::abs(scale);
+        g_spheres.set(index, center, bounds.m_radius * std::max(absScale.x, std::max(absScale.y, absScale.z)));
+    }
 
-        g_vertexBuffer = bgfx::createVertexBuffer(bgfx::makeRef(g_mesh.m_vertices.data(), sizeof(ImplVertex) * g_mesh.m_vertices.size()), g_vertexLayout);
-        g_indexBuffer = bgfx::createIndexBuffer(bgfx::makeRef(g_mesh.m_indices.data(), sizeof(ImplIndex) * g_mesh.m_indices.size()));
+    /// Moves the instances of every group into g_instances, as draws into view @p viewID.
+    void addDraws(bgfx::ViewId viewID) {
+        for(DrawGroup& group : g_groups) {
+            if(group.m_instances.empty()) continue;
+            g_draws.push_back({viewID, group.m_mesh, static_cast<uint32_t>(g_instances.size()), static_cast<uint32_t>(group.m_instances.size())});
+            g_instances.insert(g_instances.end(), group.m_instances.begin(), group.m_instances.end());
+            group.m_instances.clear();
+        }
+    }
 
+    /// Uploads g_instances and submits every Draw as one instanced draw call per part of the mesh.
+    /// Draws of fewer than g_instancingMinCount instances, or every draw without instancing support,
+    /// are submitted one instance at a time with vs_cubes, which draws them the same.
+    void submitDraws() {
+        const uint32_t count = static_cast<uint32_t>(g_instances.size());
+        const bool instancing = bgfx::isValid(g_instancedProgram);
+        if(count == 0) {
+            return;
+        }
+        if(instancing) {
+            if(count > g_instanceBufferSize) {
+                if(bgfx::isValid(g_instanceBuffer)) {
+                    bgfx::destroy(g_instanceBuffer);
+                }
+                g_instanceBufferSize = std::max(count, std::max(g_instanceBufferSize * 2, g_instanceBufferMinSize));
+                g_instanceBuffer = bgfx::createDynamicVertexBuffer(g_instanceBufferSize, g_instanceLayout);
+            }
+            bgfx::update(g_instanceBuffer, 0, bgfx::copy(g_instances.data(), count * g_instanceStride));
+        }
+
+        for(const Draw& draw : g_draws) {
+            BIGG_PROFILE_RENDER_SCOPE("{:d} instances", draw.m_count);
+            const std::vector<MeshRegistry::Buffers>& parts = MeshRegistry::getBuffers(draw.m_mesh);
+            const bool instanced = instancing && draw.m_count >= g_instancingMinCount;
+            for(const MeshRegistry::Buffers& buffers : parts) {
+                if(instanced) {
+                    bgfx::setVertexBuffer(0, buffers.m_vertexBuffer);
+                    bgfx::setIndexBuffer(buffers.m_indexBuffer);
+                    bgfx::setInstanceDataBuffer(g_instanceBuffer, draw.m_first, draw.m_count);
+                    bgfx::submit(draw.m_view, g_instancedProgram);
+                    continue;
+                }
+                for(uint32_t i = draw.m_first; i < draw.m_first + draw.m_count; i++) {
+                    bgfx::setTransform(glm::value_ptr(g_instances[i].m_transform));
+                    bgfx::setVertexBuffer(0, buffers.m_vertexBuffer);
+                    bgfx::setIndexBuffer(buffers.m_indexBuffer);
+                    bgfx::submit(draw.m_view, g_program);
+                }
+            }
+        }
+        g_instances.clear();
+        g_draws.clear();
+    }
+
+    bool onWindowCreate(const WindowCreateEvent& e) {
         bx::AllocatorI* allocator = Context::getAllocator();
-        bgfx::ShaderHandle vs = bgfx::createShader(RenderUtils::loadMem(allocator, "../thirdparty/bgfx/examples/runtime/shaders/metal/vs_cubes.bin"));
-        bgfx::ShaderHandle fs = bgfx::createShader(RenderUtils::loadMem(allocator, "../thirdparty/bgfx/examples/runtime/shaders/metal/fs_cubes.bin"));
+        bgfx::ShaderHandle vs = RenderUtils::loadExampleShader(allocator, "vs_cubes");
+        bgfx::ShaderHandle fs = RenderUtils::loadExampleShader(allocator, "fs_cubes");
         g_program = bgfx::createProgram(vs, fs, true);
 
-        bgfx::destroy(vs);
-        bgfx::destroy(fs);
+        if((bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0) {
+            bgfx::ShaderHandle instancedVs = RenderUtils::loadExampleShader(allocator, "vs_instancing");
+            bgfx::ShaderHandle instancedFs = RenderUtils::loadExampleShader(allocator, "fs_instancing");
+            g_instancedProgram = bgfx::createProgram(instancedVs, instancedFs, true);
+
+            g_instanceLayout.begin()
+                    .add(bgfx::Attrib::TexCoord7, 4, bgfx::AttribType::Float)
+                    .add(bgfx::Attrib::TexCoord6, 4, bgfx::AttribType::Float)
+                    .add(bgfx::Attrib::TexCoord5, 4, bgfx::AttribType::Float)
+                    .add(bgfx::Attrib::TexCoord4, 4, bgfx::AttribType::Float)
+                    .add(bgfx::Attrib::TexCoord3, 4, bgfx::AttribType::Float)
+                    .end();
+        }
         return false;
     }
 
-    bool onUpdate(UpdateEvent e) {
+    bool onUpdate(const UpdateEvent& e) {
         BIGG_PROFILE_RENDER_FUNCTION;
 
-        static const uint32_t viewID = 0;
-        static double counter = 0.0f;
         counter += e.m_delta;
+        if(!Context::shouldDraw()) {
+            return false;
+        }
 
-        auto view = ECS::get().view<Mesh, Transform>();
-        for(const auto& [entity, mesh, transform] : view.each()) {
-            BIGG_PROFILE_RENDER_SCOPE("foreach mesh");
-
-            {
-                const glm::vec3 at = {0.0f, 0.0f, 0.0f};
-                const glm::vec3 eye = {0.0f, 0.0f, -10.0f};
-
-                glm::ivec2 framesize = Context::getWindowFramebufferSize();
+        auto& registry = ECS::get();
+        const float alpha = static_cast<float>(e.m_alpha);
+        auto latched = registry.view<LateLatch>();
+        if(latched.begin() != latched.end()) {
+            Context::latchInput();
+        }
 
-                glm::mat4 view = glm::lookAtLH(eye, at, {0.0f, 1.0f, 0.0f});
-                glm::mat4 proj = glm::perspectiveLH(glm::radians(30.0f), (float) framesize.x / (float) framesize.y, 0.1f, 100.0f);
+        // every camera's view and projection are set once per frame, the meshes are then submitted to all of them.
+        const glm::ivec2 framebufferSize = Context::getWindowFramebufferSize();
+        g_views.clear();
+        auto cameras = registry.view<Camera, Transform>();
+        for(const auto& [entity, camera, current] : cameras.each()) {
+            setupView(camera, getDrawnTransform(registry, entity, current, alpha), framebufferSize);
+        }
+        if(cameras.begin() == cameras.end()) {
+            // no cameras, look at the origin from the front
+            const Transform eye({0.0f, 0.0f, -10.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f});
+            setupView(Camera{}, eye, framebufferSize);
+        }
+        if(g_views.empty()) {
+            return false;
+        }
 
-                bgfx::setViewTransform(viewID, glm::value_ptr(view), glm::value_ptr(proj));
+        // Gathered in parallel, each entity into the next free slot, so the order changes from frame
+        // to frame. try_get() mustn't create storages while the jobs run, so they are made here.
+        registry.view<PreviousTransform>();
+        registry.view<LateLatch>();
+        registry.view<Bounds>();
+        auto view = registry.view<Mesh, Transform>();
+        const uint32_t capacity = static_cast<uint32_t>(view.size_hint());    // at least the number of entities
+        g_drawables.resize(capacity);
+        g_spheres.resize(capacity);
+        std::atomic<uint32_t> drawableCount{0};
+        Jobs::parallelForEach<Mesh, Transform>(registry, [&registry, &drawableCount, alpha](entt::entity entity, Mesh& mesh, Transform& current) {
+            const Transform transform = getDrawnTransform(registry, entity, current, alpha);
 
+            {
                 glm::mat4 trans = glm::mat4(1.0f);
                 glm::mat4 rot_ = glm::mat4(1.0f);
                 rot_ = glm::rotate(rot_, (float)counter * 0.25f, {0.0f, 0.0f, 1.0f});
@@ -70,27 +254,61 @@ namespace {
                 trans = glm::translate(trans, transform.position);
                 trans = glm::rotate(trans, (float)counter, glm::vec3(rotDir));
                 trans = glm::scale(trans, transform.scale);
-                bgfx::setTransform(glm::value_ptr(trans));
 
+                const uint32_t index = drawableCount.fetch_add(1, std::memory_order_relaxed);
+                g_drawables[index] = {mesh.m_id, {trans}};
+                if(const Bounds* bounds = registry.try_get<Bounds>(entity)) {
+                    setWorldBounds(index, *bounds, trans, transform.scale);
+                } else {
+                    g_spheres.set(index, transform.position, std::numeric_limits<float>::infinity());
+                }
             }
-//
-//                float transform[16];
-//                bx::mtxRotateXY(transform, counter, 0.943f * counter);
-//                bgfx::setTransform(transform);
+        });
+        g_drawables.resize(drawableCount);
+        g_spheres.resize(drawableCount);
 
-            bgfx::setVertexBuffer(0, g_vertexBuffer);
-            bgfx::setIndexBuffer(g_indexBuffer);
+        // every view draws only the entities in its frustum
+        uint32_t visibleCount = 0;
+        for(const View& cameraView : g_views) {
+            Culling::cull(cameraView.m_frustum, g_spheres, g_visible);
+            visibleCount += static_cast<uint32_t>(g_visible.size());
 
-            bgfx::submit(viewID, g_program);
+            DrawGroup* group = nullptr;     // of the previous entity, which usually has the same mesh
+            for(uint32_t index : g_visible) {
+                const Drawable& drawable = g_drawables[index];
+                if(group == nullptr || group->m_mesh != drawable.m_mesh) {
+                    group = &getGroup(drawable.m_mesh);
+                }
+                group->m_instances.push_back(drawable.m_instance);
+            }
+            addDraws(cameraView.m_id);
         }
+        submitDraws();
+        // summed over the views, an entity seen by two cameras counts twice
+        const uint32_t candidateCount = static_cast<uint32_t>(g_drawables.size() * g_views.size());
+        BIGG_PROFILE_COUNTER("culling", "\"visible\": {:d}, \"culled\": {:d}", visibleCount, candidateCount - visibleCount);
+        Latency::mark(Latency::Stage::Submit);
 
         return false;
     }
 
-    bool onWindowShouldClose(WindowShouldCloseEvent e) {
-        bgfx::destroy(g_vertexBuffer);
-        bgfx::destroy(g_indexBuffer);
+    bool onWindowShouldClose(const WindowShouldCloseEvent& e) {
+        MeshRegistry::shutdown();
         bgfx::destroy(g_program);
+        if(bgfx::isValid(g_instancedProgram)) {
+            bgfx::destroy(g_instancedProgram);
+            g_instancedProgram = BGFX_INVALID_HANDLE;
+        }
+        if(bgfx::isValid(g_instanceBuffer)) {
+            bgfx::destroy(g_instanceBuffer);
+            g_instanceBuffer = BGFX_INVALID_HANDLE;
+            g_instanceBufferSize = 0;
+        }
+        g_groups.clear();
+        g_drawables.clear();
+        g_spheres.clear();
+        g_instances.clear();
+        g_draws.clear();
 
         return false;
     }
@@ -101,8 +319,7 @@ namespace {
     void init() {
         BIGG_PROFILE_INIT_FUNCTION;
 
-        //g_renderMeshComponentsPriority
-
+        MeshRegistry::init();
         Events::subscribe<WindowCreateEvent>(g_renderMeshComponentsPriority, onWindowCreate);
         Events::subscribe<UpdateEvent>(g_renderMeshComponentsPriority, onUpdate);
         Events::subscribe<WindowShouldCloseEvent>(g_renderMeshComponentsPriority, onWindowShouldClose);
@@ -2,12 +2,18 @@
 
 #include "../Core.hpp"
 #include "../Context.hpp"
+#include "../FramePacer.hpp"
+#include "../Latency.hpp"
 
 #include "RenderUtils.hpp"
 
 #include <imgui.h>
 #include <bgfx/bgfx.h>
 
+#include <algorithm>    // for std::copy
+#include <array>
+#include <cfloat>       // for FLT_MAX
+
 #include <glm/vec2.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp> // for glm::ortho()
@@ -248,6 +254,7 @@ namespace {
     };
 
     RenderUIData* data = nullptr;
+    double skippedTime = 0.0;   // UpdateEvent deltas since the last drawn frame
 
     void updateKeyModifiers(ModsEnum mods) {
         ImGuiIO& io = ImGui::GetIO();
@@ -257,7 +264,7 @@ namespace {
         io.AddKeyEvent(ImGuiKey_ModSuper, (mods & ModsEnum::Super) != 0);
     }
 
-    bool handleWindowCreateEvent(WindowCreateEvent) {
+    bool handleWindowCreateEvent(const WindowCreateEvent&) {
         BIGG_PROFILE_UI_FUNCTION;
 
         ImGuiIO &io = ImGui::GetIO();
@@ -269,20 +276,20 @@ namespace {
         return false;
     }
 
-    bool handleWindowSizeEvent(WindowSizeEvent) {
+    bool handleWindowSizeEvent(const WindowSizeEvent&) {
         ImGuiIO &io = ImGui::GetIO();
         io.DisplaySize = Context::getWindowFramebufferSize();
         // io.DisplayFramebufferScale = m_context->getWindowFramebufferSize() / m_context->getWindowSize();
         return false;
     }
 
-    bool handleWindowFocusEvent(WindowFocusEvent e) {
+    bool handleWindowFocusEvent(const WindowFocusEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         io.AddFocusEvent(e.m_focused);
         return false;
     }
 
-    bool handleMouseEnterEvent(MouseEnterEvent e) {
+    bool handleMouseEnterEvent(const MouseEnterEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         if (e.m_entered) {
             // TODO add lastValidMOusePos member
@@ -293,13 +300,13 @@ namespace {
         return false;
     }
 
-    bool handleMousePositionEvent(MousePositionEvent e) {
+    bool handleMousePositionEvent(const MousePositionEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         io.AddMousePosEvent(e.m_mousePosition.x, e.m_mousePosition.y);
         return false;
     }
 
-    bool handleMouseButtonEvent(MouseButtonEvent e) {
+    bool handleMouseButtonEvent(const MouseButtonEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         updateKeyModifiers(e.m_mods);
 
@@ -307,13 +314,13 @@ namespace {
         return io.WantCaptureMouse;
     }
 
-    bool handleScrollEvent(ScrollEvent e) {
+    bool handleScrollEvent(const ScrollEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         io.AddMouseWheelEvent(e.m_delta.x, e.m_delta.y);
         return io.WantCaptureMouse;
     }
 
-    bool handleKeyEvent(KeyEvent e) {
+    bool handleKeyEvent(const KeyEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         updateKeyModifiers(e.m_mods);
 
@@ -324,30 +331,38 @@ namespace {
         return io.WantCaptureKeyboard;
     }
 
-    bool handleCharEvent(CharEvent e) {
+    bool handleCharEvent(const CharEvent& e) {
         ImGuiIO &io = ImGui::GetIO();
         io.AddInputCharacter(e.m_codepoint);
         return io.WantCaptureKeyboard;
     }
 
-    bool handleEarlyUpdateEvent(UpdateEvent e) {
+    bool handleEarlyUpdateEvent(const UpdateEvent& e) {
         BIGG_PROFILE_UI_FUNCTION;
+        skippedTime += e.m_delta;
+        if(!Context::shouldDraw()) {
+            return false;
+        }
         ImGuiIO &io = ImGui::GetIO();
 
-        io.DeltaTime = e.m_delta;
+        io.DeltaTime = skippedTime;     // time since the last drawn frame
+        skippedTime = 0.0;
         ImGui::NewFrame();
         return false;
     }
 
-    bool handleLateUpdateEvent(UpdateEvent) {
+    bool handleLateUpdateEvent(const UpdateEvent&) {
         BIGG_PROFILE_UI_FUNCTION;
+        if(!Context::shouldDraw()) {
+            return false;
+        }
 
         BIGG_ASSERT(data != nullptr, "data isn't initialized!");
 
         // render the imgui things using bgfx
         ImGui::Render();
         ImDrawData *drawData = ImGui::GetDrawData();
-        uint32_t viewID = 1;
+        const bgfx::ViewId viewID = g_uiViewID;
 
         // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
         int fb_width = (int) (drawData->DisplaySize.x * drawData->FramebufferScale.x);
@@ -469,6 +484,20 @@ namespace {
         }
         return false;
     }
+
+    /// name of the engine's own subscribers, nullptr for anything else (eg. scripts).
+    const char* getPriorityName(uint16_t priority) {
+        switch(priority) {
+            case g_contextPriority:              return "Context";
+            case g_latencyPriority:              return "Latency";
+            case g_renderBaseBeginPriority:      return "RenderBase begin";
+            case g_renderUIBeginPriority:        return "RenderUI begin";
+            case g_renderMeshComponentsPriority: return "RenderMeshComponents";
+            case g_renderUIEndPriority:          return "RenderUI end";
+            case g_renderBaseEndPriority:        return "RenderBase end";
+            default:                             return nullptr;
+        }
+    }
 } // anonymous namespace
 
     void init() {
@@ -509,6 +538,134 @@ namespace {
         Events::subscribe<UpdateEvent>(g_renderUIEndPriority,          handleLateUpdateEvent    );
 
     }
+    void showEventStatsWindow(bool* open) {
+        BIGG_PROFILE_UI_FUNCTION;
+
+        if(!ImGui::Begin("Event Dispatch Stats", open)) {
+            ImGui::End();
+            return;
+        }
+
+        bool enabled = Events::getDispatchStatsEnabled();
+        if(ImGui::Checkbox("Enabled", &enabled)) {
+            Events::setDispatchStatsEnabled(enabled);
+        }
+        ImGui::SameLine();
+        if(ImGui::Button("Reset")) {
+            Events::resetDispatchStats();
+        }
+#if !BIGG_CONFIG_EVENT_STATS
+        ImGui::TextDisabled("Compiled out, build with BIGG_CONFIG_EVENT_STATS=1.");
+#endif
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit;
+        if(ImGui::BeginTable("subscribers", 7, flags)) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Event");
+            ImGui::TableSetupColumn("Priority");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Consumed");
+            ImGui::TableSetupColumn("Total ms");
+            ImGui::TableSetupColumn("Avg us");
+            ImGui::TableSetupColumn("Max us");
+            ImGui::TableHeadersRow();
+
+            for(const Events::SubscriberStats& stats : Events::getDispatchStats()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(Debug::g_eventTypeDebugStrings.at(stats.m_type));
+                ImGui::TableNextColumn();
+                if(const char* name = getPriorityName(stats.m_priority)) {
+                    ImGui::Text("%u (%s)", stats.m_priority, name);
+                } else {
+                    ImGui::Text("%u", stats.m_priority);
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long) stats.m_calls);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long) stats.m_consumed);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.m_totalTime * 1e3);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", stats.m_calls > 0 ? stats.m_totalTime * 1e6 / (double) stats.m_calls : 0.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", stats.m_maxTime * 1e6);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    void showFrameStatsWindow(bool* open) {
+        BIGG_PROFILE_UI_FUNCTION;
+
+        if(!ImGui::Begin("Frame Stats", open)) {
+            ImGui::End();
+            return;
+        }
+
+        float targetFrameRate = static_cast<float>(FramePacer::getTargetFrameRate());
+        if(ImGui::SliderFloat("Target FPS", &targetFrameRate, 0.0f, 240.0f, "%.0f")) {
+            FramePacer::setTargetFrameRate(targetFrameRate);
+        }
+        ImGui::SameLine();
+        if(ImGui::Button("Reset")) {
+            FramePacer::resetFrameStats();
+        }
+
+        FramePacer::FrameStats stats = FramePacer::getFrameStats();
+        ImGui::Text("Last %u frames, %u missed", stats.m_frames, stats.m_missed);
+        ImGui::Text("Frame time ms: mean %.3f, min %.3f, max %.3f, p99 %.3f, std dev %.3f",
+                    stats.m_mean * 1e3, stats.m_min * 1e3, stats.m_max * 1e3, stats.m_p99 * 1e3, stats.m_stdDev * 1e3);
+        ImGui::Text("Jitter us: mean %.1f, max %.1f", stats.m_meanJitter * 1e6, stats.m_maxJitter * 1e6);
+        ImGui::Text("Sleep overshoot estimate us: %.1f", stats.m_sleepOvershoot * 1e6);
+        ImGui::End();
+    }
+
+    void showLatencyWindow(bool* open) {
+        BIGG_PROFILE_UI_FUNCTION;
+
+        if(!ImGui::Begin("Input Latency", open)) {
+            ImGui::End();
+            return;
+        }
+
+        if(ImGui::Button("Reset")) {
+            Latency::resetStats();
+        }
+
+        Latency::Stats stats = Latency::getStats();
+        ImGui::Text("Last %u inputs, ms after the input arrived", stats.m_samples);
+        const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit;
+        if(ImGui::BeginTable("stages", 6, flags)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("Samples");
+            ImGui::TableSetupColumn("Mean");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableHeadersRow();
+            for(uint32_t stage = 0; stage < Latency::g_stageCount; stage++) {
+                const Latency::StageStats& s = stats.m_stages[stage];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(Latency::getStageName(static_cast<Latency::Stage>(stage)));
+                ImGui::TableNextColumn(); ImGui::Text("%u", s.m_samples);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", s.m_mean * 1e3);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", s.m_p50 * 1e3);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", s.m_p99 * 1e3);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", s.m_max * 1e3);
+            }
+            ImGui::EndTable();
+        }
+
+        std::array<float, g_latencyHistogramBuckets> histogram;
+        std::copy(stats.m_histogram.begin(), stats.m_histogram.end(), histogram.begin());
+        const std::string label = fmt::format("Frame latency, {:.0f}ms per bar", g_latencyHistogramBucket * 1e3);
+        ImGui::PlotHistogram("##histogram", histogram.data(), static_cast<int>(histogram.size()), 0, label.c_str(),
+                             0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+        ImGui::End();
+    }
+
     void shutdown() {
         BIGG_PROFILE_SHUTDOWN_FUNCTION;
         ImGui::DestroyContext();
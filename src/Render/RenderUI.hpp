@@ -6,5 +6,15 @@ namespace RenderUI {
     void init();
     void shutdown();
 
+    /// ImGui window with a table of Events::getDispatchStats(). Call between the UI's begin and end
+    /// UpdateEvent subscribers, like ImGui::ShowDemoWindow(). @p open works the same as there.
+    void showEventStatsWindow(bool* open = nullptr);
+
+    /// ImGui window with FramePacer::getFrameStats() and a target frame rate slider. Same usage as above.
+    void showFrameStatsWindow(bool* open = nullptr);
+
+    /// ImGui window with Latency::getStats() and a histogram of the input to frame latency. Same usage as above.
+    void showLatencyWindow(bool* open = nullptr);
+
 } // namespace RenderUI
 } // namespace BIGGEngine
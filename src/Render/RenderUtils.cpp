@@ -10,6 +10,26 @@
 
 namespace BIGGEngine {
 namespace RenderUtils {
+namespace {
+
+    /// The directory of bgfx's runtime/shaders the current renderer's shaders are in. Noop doesn't
+    /// read them, but needs valid ones.
+    const char* getShaderDirectory() {
+        switch(bgfx::getRendererType()) {
+            case bgfx::RendererType::Noop:
+            case bgfx::RendererType::Direct3D11:
+            case bgfx::RendererType::Direct3D12: return "dx11";
+            case bgfx::RendererType::Metal:      return "metal";
+            case bgfx::RendererType::OpenGL:     return "glsl";
+            case bgfx::RendererType::OpenGLES:   return "essl";
+            case bgfx::RendererType::Vulkan:     return "spirv";
+            default:
+                BIGG_ASSERT(false, "No example shaders for renderer {:d}!", static_cast<int>(bgfx::getRendererType()));
+                return "";
+        }
+    }
+
+}   // anonymous namespace
 
     const bgfx::Memory* loadMem(bx::AllocatorI* allocator, const char* filepath) {
         bx::FileReaderI* fileReader = BX_NEW(allocator, bx::FileReader);
@@ -22,5 +42,10 @@ namespace RenderUtils {
         BX_DELETE(allocator, fileReader);
         return mem;
     }
+
+    bgfx::ShaderHandle loadExampleShader(bx::AllocatorI* allocator, const char* name) {
+        const std::string filepath = fmt::format("../thirdparty/bgfx/examples/runtime/shaders/{:s}/{:s}.bin", getShaderDirectory(), name);
+        return bgfx::createShader(loadMem(allocator, filepath.c_str()));
+    }
 } // namespace RenderBase
 } // namespace BIGGEngine
\ No newline at end of file
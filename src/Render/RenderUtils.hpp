@@ -13,6 +13,10 @@ namespace RenderUtils {
 
     const bgfx::Memory* loadMem(bx::AllocatorI* allocator, const char* filepath);
 
+    /// Loads one of bgfx's example shaders by name (eg. "vs_cubes"), compiled for the renderer bgfx
+    /// is running, as the examples' own loadShader() picks it.
+    bgfx::ShaderHandle loadExampleShader(bx::AllocatorI* allocator, const char* name);
+
 } // namespace RenderBase
 } // namespace BIGGEngine
 
@@ -9,6 +9,9 @@
 
 #include "Script.hpp"
 #include "Macros.hpp"
+#include "CustomEvents.hpp"
+#include "Latency.hpp"
+#include "Timers.hpp"
 
 #define BIGG_PROFILE_SCRIPT_FUNCTION            _BIGG_PROFILE_CATEGORY_FUNCTION("script")
 #define BIGG_PROFILE_SCRIPT_SCOPE(_format, ...) _BIGG_PROFILE_CATEGORY_SCOPE("script", _format, ##__VA_ARGS__)
@@ -209,6 +212,36 @@ int l_setClipboardString(lua_State* L); // std::string text
 // TODO get/set monitor???
 #include "../scripts/LuaContextFunctions.inl"
 
+// -------------------- Custom Events and Timers ------------------------
+
+const char* g_RegisterEventFuncName     = "registerEvent";
+const char* g_SetEventFuncName          = "setEvent";
+const char* g_SubscribeEventFuncName    = "subscribeEvent";
+const char* g_UnsubscribeEventFuncName  = "unsubscribeEvent";
+const char* g_ScheduleAfterFuncName     = "scheduleAfter";
+const char* g_CancelTimerFuncName       = "cancelTimer";
+
+// registry tables holding the lua functions, so the C++ callbacks only capture a key.
+const char* g_EventCallbacksTableName   = "BIGGEngine.EventCallbacks";  // key is eventCallbackKey(id, priority)
+const char* g_TimerCallbacksTableName   = "BIGGEngine.TimerCallbacks";  // key is the timer returned to lua
+
+/// Lua custom events carry up to this many numbers as their payload.
+const int g_maxLuaEventValues = 16;
+
+// timers scheduled from lua, by their state and the key returned to lua
+std::unordered_map<lua_State*, std::unordered_map<lua_Integer, Events::TimerHandle>> g_luaTimers;
+lua_Integer g_nextLuaTimerKey = 0;
+
+int l_registerEvent(lua_State* L); // std::string name, int valueCount, [int capacity]
+int l_setEvent(lua_State* L); // int id, number... values
+int l_subscribeEvent(lua_State* L); // int id, int priority, function callback
+int l_unsubscribeEvent(lua_State* L); // int id, int priority
+int l_scheduleAfter(lua_State* L); // number delay, function callback, [number period]
+int l_cancelTimer(lua_State* L); // int timer
+void cancelLuaTimers(lua_State* L);    // before L is closed, the timers call into it
+
+#include "../scripts/LuaEvents.inl"
+
 // -------------- Vector Handle -------------------------------
 
 using vec2h = glm::vec2;
@@ -408,6 +441,14 @@ const luaL_Reg BIGGEnginelib[] = {
         {g_SetClipboardStringFuncName,         l_setClipboardString},
         {g_SetWindowVisibleFuncName,           l_setWindowVisible},
 
+        // Custom Event and Timer funcs
+        {g_RegisterEventFuncName,              l_registerEvent},
+        {g_SetEventFuncName,                   l_setEvent},
+        {g_SubscribeEventFuncName,             l_subscribeEvent},
+        {g_UnsubscribeEventFuncName,           l_unsubscribeEvent},
+        {g_ScheduleAfterFuncName,              l_scheduleAfter},
+        {g_CancelTimerFuncName,                l_cancelTimer},
+
         // Component funcs
         {g_TransformComponentIndexFuncName,    l_TransformComponentIndex},
         {g_TransformComponentNewIndexFuncName, l_TransformComponentNewIndex},
@@ -657,7 +698,7 @@ ScriptHandle::ScriptHandle(entt::hashed_string name, std::string_view filepath,
     lua_getfield(m_luaState, -1, "WindowCreate");
     if(lua_isfunction(m_luaState, -1)) {
         // setup callback
-        auto callback = [=](WindowCreateEvent event) -> bool {   // captures this.m_luaState and name
+        auto callback = [=](const WindowCreateEvent& event) -> bool {   // captures this.m_luaState and name
             _BIGG_PROFILE_CATEGORY_SCOPE("script", "callback");
 
             lua_getglobal(m_luaState, "BIGGEngine");
@@ -730,7 +771,7 @@ ScriptHandle::ScriptHandle(entt::hashed_string name, std::string_view filepath,
     lua_getfield(m_luaState, -1, "MouseButton");
     if(lua_isfunction(m_luaState, -1)) {
         // setup callback
-        auto callback = [=](MouseButtonEvent event) -> bool {   // captures this.m_luaState and name
+        auto callback = [=](const MouseButtonEvent& event) -> bool {   // captures this.m_luaState and name
             _BIGG_PROFILE_CATEGORY_SCOPE("script", "callback");
 
             lua_getglobal(m_luaState, "BIGGEngine");
@@ -774,6 +815,7 @@ ScriptHandle::ScriptHandle(entt::hashed_string name, std::string_view filepath,
                     lua_error(m_luaState);
                     return false;
                 }
+                Latency::mark(Latency::Stage::Script);
                 // get return value
                 if(!lua_isboolean(m_luaState, -1)) {
                     // error! should have returned a bool!
@@ -810,6 +852,7 @@ ScriptHandle::ScriptHandle(entt::hashed_string name, std::string_view filepath,
 
 ScriptHandle::~ScriptHandle() {
     BIGG_PROFILE_SHUTDOWN_FUNCTION;
+    cancelLuaTimers(m_luaState);
     lua_close(m_luaState);
 }
 
@@ -0,0 +1,170 @@
+//      Sorted subscriber lists, shared by Events.cpp and CustomEvents.cpp. Internal to them.
+
+// Subscribers are kept in a contiguous array sorted by priority, so dispatching walks it front to
+// back. Subscribing or unsubscribing while the list is being dispatched is deferred until the
+// dispatch finishes, so the array is never reallocated under a running callback.
+#pragma once
+
+#include "Config.hpp"
+#include "Events.hpp"   // for SubscriberStats
+#include "Profile.hpp"
+
+#include <algorithm>    // for std::lower_bound, std::find_if, std::remove_if
+#include <vector>
+
+namespace BIGGEngine {
+namespace Events {
+
+#if BIGG_CONFIG_EVENT_STATS
+    /// Timings of one subscriber's calls, see setDispatchStatsEnabled().
+    struct DispatchStats {
+        void add(double time, bool consumed) {
+            ++m_calls;
+            m_consumed += consumed;
+            m_totalTime += time;
+            m_maxTime = std::max(m_maxTime, time);
+        }
+
+        uint64_t m_calls = 0;
+        uint64_t m_consumed = 0;
+        double m_totalTime = 0.0;
+        double m_maxTime = 0.0;
+    };
+#endif
+
+    template<typename Functor>
+    struct Subscriber {
+        uint16_t m_priority;
+        Functor m_functor;
+#if BIGG_CONFIG_EVENT_STATS
+        DispatchStats m_stats;
+#endif
+    };
+
+    /// Subscribers calling a @p Functor which returns true to consume what it is called with.
+    template<typename Functor>
+    struct Subscribers {
+
+        /// False if @p priority is taken.
+        bool add(uint16_t priority, Functor&& functor) {
+            if(find(m_list, priority) != m_list.end() || find(m_added, priority) != m_added.end()) {
+                return false;
+            }
+            if(m_dispatchDepth > 0) {
+                m_added.push_back({priority, std::move(functor)});
+                return true;
+            }
+            auto it = std::lower_bound(m_list.begin(), m_list.end(), priority, lessPriority);
+            m_list.insert(it, {priority, std::move(functor)});
+            return true;
+        }
+
+        bool remove(uint16_t priority) {
+            auto it = find(m_list, priority);
+            if(it != m_list.end()) {
+                if(m_dispatchDepth > 0) {
+                    it->m_functor = nullptr;    // skipped by dispatch, erased by flush()
+                    m_hasRemoved = true;
+                } else {
+                    m_list.erase(it);
+                }
+                return true;
+            }
+            it = find(m_added, priority);
+            if(it != m_added.end()) {
+                m_added.erase(it);
+                return true;
+            }
+            return false;
+        }
+
+        /// Calls subscribers in priority order until one consumes @p e. With @p timed, every call
+        /// is added to the subscriber's stats.
+        template<typename Arg>
+        void dispatch(const Arg& e, bool timed = false) {
+            ++m_dispatchDepth;
+#if BIGG_CONFIG_EVENT_STATS
+            if(timed) {
+                dispatchTimed(e);
+            } else
+#endif
+            for(Subscriber<Functor>& subscriber : m_list) {
+                if(subscriber.m_functor && subscriber.m_functor(e)) break;
+            }
+            if(--m_dispatchDepth == 0) {
+                flush();
+            }
+        }
+
+#if BIGG_CONFIG_EVENT_STATS
+        void appendStats(EventType type, std::vector<SubscriberStats>& out) const {
+            for(const Subscriber<Functor>& subscriber : m_list) {
+                if(!subscriber.m_functor) continue;
+                const DispatchStats& stats = subscriber.m_stats;
+                out.push_back({type, subscriber.m_priority, stats.m_calls, stats.m_consumed, stats.m_totalTime, stats.m_maxTime});
+            }
+        }
+
+        void resetStats() {
+            for(Subscriber<Functor>& subscriber : m_list) {
+                subscriber.m_stats = DispatchStats{};
+            }
+        }
+#endif
+
+        void clear() {
+            m_list.clear();
+            m_added.clear();
+            m_hasRemoved = false;
+        }
+
+    private:
+        using List = std::vector<Subscriber<Functor>>;
+
+        static bool lessPriority(const Subscriber<Functor>& subscriber, uint16_t priority) {
+            return subscriber.m_priority < priority;
+        }
+
+        static typename List::iterator find(List& list, uint16_t priority) {
+            // m_added isn't sorted, so just do a linear search. Lists are short anyways.
+            return std::find_if(list.begin(), list.end(), [priority](const Subscriber<Functor>& subscriber) {
+                return subscriber.m_priority == priority && subscriber.m_functor;
+            });
+        }
+
+#if BIGG_CONFIG_EVENT_STATS
+        template<typename Arg>
+        void dispatchTimed(const Arg& e) {
+            for(Subscriber<Functor>& subscriber : m_list) {
+                if(!subscriber.m_functor) continue;
+                double start = Profile::now();
+                bool consumed = subscriber.m_functor(e);
+                subscriber.m_stats.add(Profile::now() - start, consumed);
+                if(consumed) break;
+            }
+        }
+#endif
+
+        /// apply changes which were deferred during dispatch.
+        void flush() {
+            if(m_hasRemoved) {
+                m_list.erase(std::remove_if(m_list.begin(), m_list.end(), [](const Subscriber<Functor>& subscriber) {
+                    return !subscriber.m_functor;
+                }), m_list.end());
+                m_hasRemoved = false;
+            }
+            for(Subscriber<Functor>& subscriber : m_added) {
+                auto it = std::lower_bound(m_list.begin(), m_list.end(), subscriber.m_priority, lessPriority);
+                m_list.insert(it, std::move(subscriber));
+            }
+            m_added.clear();
+        }
+
+        List m_list;
+        List m_added;
+        uint32_t m_dispatchDepth = 0;
+        bool m_hasRemoved = false;
+    };
+
+} // namespace Events
+} // namespace BIGGEngine
@@ -0,0 +1,256 @@
+#include "Timers.hpp"
+
+#include "Core.hpp"
+
+#include <array>
+#include <cmath>    // for std::ceil
+#include <vector>
+
+namespace BIGGEngine {
+namespace Events {
+namespace {
+
+    constexpr uint32_t g_nil = UINT32_MAX;
+
+    constexpr uint32_t g_slotBits = 8;
+    constexpr uint32_t g_slotCount = 1u << g_slotBits;     // slots per level
+    constexpr uint32_t g_levelCount = 4;
+    constexpr uint64_t g_maxDelay = (uint64_t(1) << (g_slotBits * g_levelCount)) - 1;
+
+    constexpr double g_timeUnitsPerSecond = 1000.0;   // the time wheel has 1ms resolution
+
+    enum struct Wheel : uint8_t { Time, Ticks };
+
+    struct TimerNode {
+        TimerCallback m_callback;
+        uint64_t m_expire = 0;      // in wheel units
+        uint64_t m_period = 0;      // 0 if not periodic
+        uint32_t m_prev = g_nil;
+        uint32_t m_next = g_nil;    // also links the free list
+        uint32_t m_generation = 0;
+        uint16_t m_slot = 0;        // level * g_slotCount + index
+        Wheel m_wheel = Wheel::Time;
+        bool m_active = false;
+    };
+
+    /// All timers of both wheels. Indices are stable, the vector only grows.
+    std::vector<TimerNode> nodes;
+    uint32_t freeList = g_nil;
+
+    uint32_t allocateNode() {
+        if(freeList != g_nil) {
+            uint32_t index = freeList;
+            freeList = nodes[index].m_next;
+            return index;
+        }
+        nodes.emplace_back();
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void freeNode(uint32_t index) {
+        TimerNode& node = nodes[index];
+        node.m_callback = nullptr;
+        node.m_active = false;
+        ++node.m_generation;    // invalidates outstanding handles
+        node.m_prev = g_nil;
+        node.m_next = freeList;
+        freeList = index;
+    }
+
+    struct TimerWheel {
+
+        void insert(uint32_t index) {
+            // expects m_expire >= m_now. Only cascade() inserts timers which expire right now, into
+            // the level 0 slot which is about to be expired.
+            TimerNode& node = nodes[index];
+            if(node.m_expire - m_now > g_maxDelay) node.m_expire = m_now + g_maxDelay;
+
+            // lowest level whose range covers the delay
+            uint64_t delay = node.m_expire - m_now;
+            uint32_t level = 0;
+            while(level + 1 < g_levelCount && delay >= (uint64_t(1) << (g_slotBits * (level + 1)))) {
+                level++;
+            }
+            uint32_t slot = level * g_slotCount + static_cast<uint32_t>((node.m_expire >> (g_slotBits * level)) & (g_slotCount - 1));
+
+            node.m_slot = static_cast<uint16_t>(slot);
+            node.m_prev = g_nil;
+            node.m_next = m_slots[slot];
+            if(m_slots[slot] != g_nil) nodes[m_slots[slot]].m_prev = index;
+            m_slots[slot] = index;
+            ++m_count;
+        }
+
+        void unlink(uint32_t index) {
+            TimerNode& node = nodes[index];
+            if(node.m_prev != g_nil) {
+                nodes[node.m_prev].m_next = node.m_next;
+            } else {
+                m_slots[node.m_slot] = node.m_next;
+            }
+            if(node.m_next != g_nil) nodes[node.m_next].m_prev = node.m_prev;
+            node.m_prev = node.m_next = g_nil;
+            --m_count;
+        }
+
+        void advanceTo(uint64_t target) {
+            while(m_now < target) {
+                if(m_count == 0) {
+                    m_now = target;     // nothing can expire, skip ahead
+                    return;
+                }
+                ++m_now;
+
+                // Every 256^level units, move the next slot of that level down to the levels below.
+                for(uint32_t level = g_levelCount - 1; level > 0; level--) {
+                    if((m_now & ((uint64_t(1) << (g_slotBits * level)) - 1)) == 0) {
+                        cascade(level * g_slotCount + static_cast<uint32_t>((m_now >> (g_slotBits * level)) & (g_slotCount - 1)));
+                    }
+                }
+                expire(static_cast<uint32_t>(m_now & (g_slotCount - 1)));
+            }
+        }
+
+        void clear() {
+            m_slots.fill(g_nil);
+            m_count = 0;
+        }
+
+        std::array<uint32_t, g_levelCount * g_slotCount> m_slots;  // head of each slot's list
+        uint64_t m_now = 0;
+        uint32_t m_count = 0;
+
+    private:
+        void cascade(uint32_t slot) {
+            uint32_t index = m_slots[slot];
+            m_slots[slot] = g_nil;
+            while(index != g_nil) {
+                uint32_t next = nodes[index].m_next;
+                --m_count;  // insert() counts it again
+                insert(index);
+                index = next;
+            }
+        }
+
+        void expire(uint32_t slot) {
+            // Pop one timer at a time, so callbacks may cancel or schedule any timer.
+            while(m_slots[slot] != g_nil) {
+                uint32_t index = m_slots[slot];
+                unlink(index);
+
+                // Take the callback out of the node: scheduling a timer in the callback may grow
+                // (reallocate) the node vector.
+                TimerCallback callback = std::move(nodes[index].m_callback);
+                uint32_t generation = nodes[index].m_generation;
+                bool periodic = nodes[index].m_period != 0;
+
+                if(periodic) {
+                    nodes[index].m_expire = m_now + nodes[index].m_period;
+                    insert(index);
+                } else {
+                    freeNode(index);
+                }
+
+                callback();
+
+                // put it back, unless the timer cancelled itself.
+                if(periodic && nodes[index].m_generation == generation) {
+                    nodes[index].m_callback = std::move(callback);
+                }
+            }
+        }
+    };
+
+    TimerWheel timeWheel;
+    TimerWheel tickWheel;
+    double time = 0.0;  // sum of UpdateEvent::m_delta, in seconds
+
+    TimerWheel& getWheel(Wheel wheel) {
+        return wheel == Wheel::Time ? timeWheel : tickWheel;
+    }
+
+    TimerHandle schedule(Wheel wheel, uint64_t delay, uint64_t period, TimerCallback&& callback) {
+        uint32_t index = allocateNode();
+        TimerNode& node = nodes[index];
+        node.m_callback = std::move(callback);
+        node.m_expire = getWheel(wheel).m_now + (delay > 0 ? delay : 1);   // the current unit was already expired
+        node.m_period = period;
+        node.m_wheel = wheel;
+        node.m_active = true;
+        getWheel(wheel).insert(index);
+        return {index, node.m_generation};
+    }
+
+    uint64_t toTimeUnits(double seconds) {
+        // the epsilon keeps eg. 4.025s from rounding up to 4026ms
+        return seconds > 0.0 ? static_cast<uint64_t>(std::ceil(seconds * g_timeUnitsPerSecond - 1e-6)) : 0;
+    }
+
+    bool handleUpdate(const UpdateEvent& e) {
+        BIGG_PROFILE_RUN_FUNCTION;
+        time += e.m_delta;
+        // the epsilon stops rounding errors in the sum from delaying a timer by a whole frame.
+        timeWheel.advanceTo(static_cast<uint64_t>(time * g_timeUnitsPerSecond + 1e-6));
+        return false;
+    }
+
+    bool handleTick(const TickEvent&) {
+        tickWheel.advanceTo(tickWheel.m_now + 1);
+        return false;
+    }
+
+} // anonymous namespace
+
+    TimerHandle scheduleAfter(double delay, TimerCallback&& callback, double period) {
+        BIGG_ASSERT(callback, "Trying to schedule an empty callback.");
+        return schedule(Wheel::Time, toTimeUnits(delay), toTimeUnits(period), std::move(callback));
+    }
+
+    TimerHandle scheduleAfterTicks(uint32_t ticks, TimerCallback&& callback, uint32_t period) {
+        BIGG_ASSERT(callback, "Trying to schedule an empty callback.");
+        return schedule(Wheel::Ticks, ticks, period, std::move(callback));
+    }
+
+    bool isTimerPending(TimerHandle handle) {
+        return handle.m_index < nodes.size()
+            && nodes[handle.m_index].m_active
+            && nodes[handle.m_index].m_generation == handle.m_generation;
+    }
+
+    bool cancelTimer(TimerHandle handle) {
+        if(!isTimerPending(handle)) return false;
+
+        TimerNode& node = nodes[handle.m_index];
+        // a periodic timer which cancels itself from its callback is linked into the wheel
+        // already, so this works for it too.
+        getWheel(node.m_wheel).unlink(handle.m_index);
+        freeNode(handle.m_index);
+        return true;
+    }
+
+    uint32_t getTimerCount() {
+        return timeWheel.m_count + tickWheel.m_count;
+    }
+
+    void initTimers() {
+        // keep the nodes so their generations keep invalidating old handles
+        freeList = g_nil;
+        for(uint32_t index = static_cast<uint32_t>(nodes.size()); index-- > 0;) {
+            if(nodes[index].m_active) {
+                freeNode(index);
+            } else {
+                nodes[index].m_next = freeList;
+                freeList = index;
+            }
+        }
+        timeWheel.clear();
+        tickWheel.clear();
+        timeWheel.m_now = tickWheel.m_now = 0;
+        time = 0.0;
+
+        subscribe<UpdateEvent>(g_timersPriority, handleUpdate);
+        subscribe<TickEvent>(g_timersPriority, handleTick);
+    }
+
+} // namespace Events
+} // namespace BIGGEngine
@@ -0,0 +1,66 @@
+//      Delayed and periodic callbacks / events, kept in two hierarchical timer wheels: one counts
+//      time (the sum of UpdateEvent::m_delta, 1ms resolution) and one counts TickEvents.
+
+// Each wheel has 4 levels of 256 slots. Level 0 holds timers which expire within 256 units, level 1
+// within 256^2 units and so on. Inserting and cancelling a timer is O(1). Advancing one unit only
+// looks at one level 0 slot, and every 256 units the next level 1 slot is moved down a level.
+// Pending timers which aren't about to expire cost nothing per frame.
+
+// Time only advances through UpdateEvents, so timers behave the same when replaying a recording.
+#pragma once
+
+#include "Functor.hpp"
+#include "Events.hpp"
+
+#include <stdint.h>
+
+namespace BIGGEngine {
+namespace Events {
+
+    using TimerCallback = Functor<void()>;
+
+    /// Identifies a scheduled timer. Stays safe to use after the timer fired or was cancelled.
+    struct TimerHandle {
+        uint32_t m_index = UINT32_MAX;
+        uint32_t m_generation = 0;
+
+        bool isValid() const { return m_index != UINT32_MAX; }
+    };
+
+    /// Calls @p callback after @p delay seconds, then every @p period seconds if @p period > 0.
+    TimerHandle scheduleAfter(double delay, TimerCallback&& callback, double period = 0.0);
+
+    /// Calls @p callback after @p ticks TickEvents, then every @p period ticks if @p period > 0.
+    TimerHandle scheduleAfterTicks(uint32_t ticks, TimerCallback&& callback, uint32_t period = 0);
+
+    /// Sets @p event after @p delay seconds (and every @p period seconds if @p period > 0).
+    template<typename Event>
+    TimerHandle scheduleEvent(double delay, Event&& event, double period = 0.0) {
+        if(period > 0.0) {
+            return scheduleAfter(delay, [e = std::move(event)]() { setEvent<Event>(Event(e)); }, period);
+        }
+        return scheduleAfter(delay, [e = std::move(event)]() mutable { setEvent<Event>(std::move(e)); });
+    }
+
+    /// Sets @p event after @p ticks TickEvents (and every @p period ticks if @p period > 0).
+    template<typename Event>
+    TimerHandle scheduleEventTicks(uint32_t ticks, Event&& event, uint32_t period = 0) {
+        if(period > 0) {
+            return scheduleAfterTicks(ticks, [e = std::move(event)]() { setEvent<Event>(Event(e)); }, period);
+        }
+        return scheduleAfterTicks(ticks, [e = std::move(event)]() mutable { setEvent<Event>(std::move(e)); });
+    }
+
+    /// Returns false if the timer already fired (and isn't periodic) or was cancelled.
+    bool cancelTimer(TimerHandle handle);
+    bool isTimerPending(TimerHandle handle);
+
+    /// Number of scheduled timers on both wheels.
+    uint32_t getTimerCount();
+
+    /// Cancels every timer and subscribes the wheels to UpdateEvent / TickEvent at g_timersPriority.
+    /// Called by Events::init() and Events::reset().
+    void initTimers();
+
+} // namespace Events
+} // namespace BIGGEngine
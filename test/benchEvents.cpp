@@ -0,0 +1,108 @@
+// Compares the old subscriber dispatch (std::map of std::function, event passed by value) with the
+// current one (priority sorted std::vector of Functor, event passed by const reference).
+//
+// Both paths are reimplemented here so that the benchmark measures only the dispatch, not the event
+// queues. Run the Release build, eg. `./benchEvents 1000000`.
+
+#include "../src/Functor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace BIGGEngine;
+
+struct SmallEvent {
+    double m_delta;
+};
+
+struct PathsEvent {
+    std::vector<std::string> m_paths;
+};
+
+template<typename Event>
+struct MapDispatcher {
+    std::map<uint16_t, std::function<bool(Event)>> m_callbacks;
+
+    void dispatch(const Event& e) {
+        for(auto& [priority, functor] : m_callbacks) {
+            if(functor(e)) break;
+        }
+    }
+};
+
+template<typename Event>
+struct FlatDispatcher {
+    struct Subscriber {
+        uint16_t m_priority;
+        EventFunctor<Event> m_functor;
+    };
+    std::vector<Subscriber> m_callbacks;
+
+    void add(uint16_t priority, EventFunctor<Event>&& functor) {
+        auto it = std::lower_bound(m_callbacks.begin(), m_callbacks.end(), priority,
+                                   [](const Subscriber& s, uint16_t p) { return s.m_priority < p; });
+        m_callbacks.insert(it, {priority, std::move(functor)});
+    }
+
+    void dispatch(const Event& e) {
+        for(Subscriber& subscriber : m_callbacks) {
+            if(subscriber.m_functor(e)) break;
+        }
+    }
+};
+
+template<typename Func>
+double timeIt(uint64_t iterations, Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i < iterations; i++) {
+        func();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (double)iterations;
+}
+
+/// registers @p subscriberCount non-consuming subscribers on both dispatchers and times them.
+template<typename Event>
+void bench(const char* name, const Event& event, uint32_t subscriberCount, uint64_t iterations) {
+    double sink = 0.0;    // logged at the end so the subscribers can't be optimized out
+
+    MapDispatcher<Event> oldPath;
+    FlatDispatcher<Event> newPath;
+    for(uint16_t priority = 0; priority < subscriberCount; priority++) {
+        double* pSink = &sink;
+        oldPath.m_callbacks[priority] = [pSink, priority](Event) { *pSink += priority; return false; };
+        newPath.add(priority, [pSink, priority](const Event&) { *pSink += priority; return false; });
+    }
+
+    double oldNs = timeIt(iterations, [&] { oldPath.dispatch(event); });
+    double newNs = timeIt(iterations, [&] { newPath.dispatch(event); });
+
+    BIGG_LOG_INFO("{:<12s} {:>3d} subscribers: map+std::function {:8.1f} ns, vector+Functor {:8.1f} ns ({:.2f}x)",
+                  name, subscriberCount, oldNs, newNs, oldNs / newNs);
+    BIGG_LOG_DEBUG("sink {}", sink);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    using namespace BIGGEngine;
+    Log::setLevel(Log::LogLevel::Info);
+    Log::init();
+
+    uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 1000000;
+
+    SmallEvent small{0.016};
+    PathsEvent paths{{"../res/models/testbunny.bin", "../res/fonts/Hasklig-Semibold.otf", "../test/main.lua"}};
+
+    for(uint32_t subscribers : {1u, 4u, 16u}) {
+        bench("SmallEvent", small, subscribers, iterations);
+        bench("PathsEvent", paths, subscribers, iterations / 10);
+    }
+    return 0;
+}
@@ -1,10 +1,14 @@
 #include "../src/Core.hpp"
 #include "../src/Context.hpp"
 #include "../src/ContextImplGLFW.hpp"
+#include "../src/ContextImplHeadless.hpp"
+#include "../src/Latency.hpp"
 #include "../src/Render/RenderBase.hpp"
+#include "../src/Render/MeshLoader.hpp"
 #include "../src/Render/RenderMeshComponents.hpp"
 #include "../src/Render/RenderUI.hpp"
 
+#include "../src/Recorder.hpp"
 #include "../src/Script.hpp"
 
 #include <imgui.h>
@@ -12,23 +16,46 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/constants.hpp>    // for glm::one_over_root_two
 
+#include <cmath>    // for std::ceil, std::sqrt
+#include <cstdlib>  // for std::strtoul
+#include <cstring>  // for std::strcmp
+
 namespace BIGGEngine {
 
 struct App {
-    
-    App()  {
+
+    enum class Mode {
+        Window,     // GLFW window
+        Headless,   // no window, bgfx Noop renderer. For servers and CI.
+        Replay,     // no context or renderer, for replaying a recording.
+    };
+
+    /// @p frameCount is how many frames Headless mode runs for. 0 runs until closed.
+    /// @p renderThread renders on the main thread and runs the engine on its own.
+    explicit App(Mode mode, uint32_t frameCount = 0, bool renderThread = false) : m_mode(mode) {
         BIGG_PROFILE_INIT_FUNCTION;
 
         Events::setEvent<WindowCreateEvent>({{720, 600}, "Best Window in the World"});
-        Events::subscribe<UpdateEvent>(100, [this](UpdateEvent) { return update(); });
-        Events::subscribe<WindowDestroyEvent>(100, [](WindowDestroyEvent e) { BIGG_LOG_INFO("Window destroyed."); return false; });
-        Events::subscribe<ScrollEvent>(100, [](ScrollEvent e) { BIGG_LOG_INFO("scrolled {: .2f}", e.m_delta); return false; } );
+        if(m_mode == Mode::Window) {
+            Events::subscribe<UpdateEvent>(100, [this](const UpdateEvent&) { return update(); });
+        }
+        Events::subscribe<WindowDestroyEvent>(100, [](const WindowDestroyEvent& e) { BIGG_LOG_INFO("Window destroyed."); return false; });
+        Events::subscribe<ScrollEvent>(100, [](const ScrollEvent& e) { BIGG_LOG_INFO("scrolled {: .2f}", e.m_delta); return false; } );
 
         Context::init();
-        GLFWContext::init();
-        RenderBase::init();
-        RenderUI::init();
-        RenderMeshComponents::init();
+        if(m_mode == Mode::Window) {
+            GLFWContext::init();
+            RenderBase::init(false, renderThread);
+            RenderUI::init();
+            RenderMeshComponents::init();
+            Latency::init();
+        } else if(m_mode == Mode::Headless) {
+            // no RenderUI, update() draws ImGui windows. Meshes are culled, batched and submitted like in a
+            // window, bgfx's Noop renderer only skips the GPU work.
+            HeadlessContext::init({frameCount});
+            RenderBase::init(true, renderThread);
+            RenderMeshComponents::init();
+        }
 
 
         // this should add the script "main" to the registry and run the script once.
@@ -54,31 +81,76 @@ struct App {
         reg.emplace<Mesh>(entity3);
         reg.emplace<Transform>(entity3, glm::vec3{-1, -1.5, 0.0f}, glm::vec3{0, 1, 0}, glm::vec3{0.5, 1, 0.5});
 
-        // TODO make mesh rendering gooder
-        // v1 static loading
-        // global registry of known meshes
-        // - index-able by asset name or path or UUID
-        // - metadata:
-        //     - bgfx::vertexLayout
-        //     - pointer to vertex / index data in heap
-        //     - size?
-        // allocator with some heap size
+        const auto camera = reg.create();
+        reg.emplace<Transform>(camera, glm::vec3{0, 0, -10}, glm::vec3{0, 0, 0}, glm::vec3{1, 1, 1});
+        reg.emplace<Camera>(camera);
+
+        // top down view in the corner, drawn after the main camera
+        const auto minimap = reg.create();
+        reg.emplace<Transform>(minimap, glm::vec3{0, 10, 0}, glm::vec3{0, 0, 0}, glm::vec3{1, 1, 1});
+        Camera& minimapCamera = reg.emplace<Camera>(minimap);
+        minimapCamera.m_viewID = 1;
+        minimapCamera.m_viewport = {0.75f, 0.0f, 0.25f, 0.25f};
+        minimapCamera.m_up = {0.0f, 0.0f, 1.0f};
+        minimapCamera.m_clearColour = 0x303030ff;
+
+        // follows the cursor, latched right before drawing so it doesn't lag behind.
+        const auto cursor = reg.create();
+        reg.emplace<Mesh>(cursor);
+        reg.emplace<Transform>(cursor, glm::vec3{0, 0, 0}, glm::vec3{0, 0, 0}, glm::vec3{0.1, 0.1, 0.1});
+        reg.emplace<LateLatch>(cursor, [](entt::entity, Transform& transform) {
+            const glm::dvec2 mouse = Context::getMousePosition();
+            const glm::ivec2 size = Context::getWindowSize();
+            if(size.x > 0 && size.y > 0) {
+                transform.position.x = static_cast<float>(mouse.x / size.x - 0.5) * 5.0f;
+                transform.position.y = static_cast<float>(0.5 - mouse.y / size.y) * 5.0f;
+            }
+        });
+
+        // memory mapped and uploaded without a copy. Drawn in its entity colour like every mesh, since
+        // vs_instancing only needs the positions.
+        if(m_mode != Mode::Replay && MeshLoader::load(entt::hashed_string{"bunny"}, "../res/models/testbunny.bin")) {
+            const auto bunny = reg.create();
+            reg.emplace<Mesh>(bunny, entt::hashed_string{"bunny"}.value());
+            reg.emplace<Transform>(bunny, glm::vec3{2, -1, 0}, glm::vec3{0, 0, 0}, glm::vec3{1, 1, 1});
+        }
 
+        // TODO allocator with some heap size for mesh data (see MeshRegistry)
     }
 
     ~App() {
-        RenderUI::shutdown();
+        if(m_mode == Mode::Window) {
+            RenderUI::shutdown();
+        }
         Context::shutdown();
         ECS::shutdown();
     }
 
+    /// A grid of @p count small cubes behind the others, to see how mesh rendering scales.
+    void spawnCubes(uint32_t count) {
+        auto& reg = ECS::get();
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+        for(uint32_t i = 0; i < count; i++) {
+            const glm::vec3 position{(i % side) * 0.2f - side * 0.1f, (i / side) * 0.2f - side * 0.1f, 20.0f};
+            const auto entity = reg.create();
+            reg.emplace<Mesh>(entity);
+            reg.emplace<Transform>(entity, position, glm::vec3{0, 0, 0}, glm::vec3{0.05, 0.05, 0.05});
+        }
+    }
+
     void tick(double delta) {
         // BIGG_LOG_INFO("tick: {:3.3f}ms", delta * 1e3);
     }
 
     bool update() {
         BIGG_PROFILE_RUN_FUNCTION;
+        if(!Context::shouldDraw()) {
+            return false;
+        }
         ImGui::ShowDemoWindow();
+        RenderUI::showEventStatsWindow();
+        RenderUI::showFrameStatsWindow();
+        RenderUI::showLatencyWindow();
         return false;
     }
 
@@ -93,15 +165,33 @@ struct App {
             Context::setClipboardString(event->m_paths.at(0));
         } 
     }
+
+    Mode m_mode;
 };
 
 }   // namespace BIGGEngine
 
-int main() {
+// usage: test [--record <file>] [--replay <file>] [--headless <frames>] [--render-thread] [--high-frequency-input] [--cubes <count>]
+int main(int argc, char** argv) {
 
     using namespace BIGGEngine;
     App* app;
     int result;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* headlessFrames = nullptr;
+    bool renderThread = false;
+    bool highFrequencyInput = false;
+    const char* cubeCount = nullptr;
+    for(int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if(std::strcmp(argv[i], "--record") == 0 && hasValue) recordPath = argv[++i];
+        else if(std::strcmp(argv[i], "--replay") == 0 && hasValue) replayPath = argv[++i];
+        else if(std::strcmp(argv[i], "--headless") == 0 && hasValue) headlessFrames = argv[++i];
+        else if(std::strcmp(argv[i], "--render-thread") == 0) renderThread = true;
+        else if(std::strcmp(argv[i], "--high-frequency-input") == 0) highFrequencyInput = true;
+        else if(std::strcmp(argv[i], "--cubes") == 0 && hasValue) cubeCount = argv[++i];
+    }
     {
         BIGG_PROFILE_INIT_SCOPE("Init");
 
@@ -110,11 +200,25 @@ int main() {
 
         Events::init();
 
-        app = new App();
+        if(replayPath) app = new App(App::Mode::Replay);
+        else if(headlessFrames) app = new App(App::Mode::Headless, std::strtoul(headlessFrames, nullptr, 10), renderThread);
+        else app = new App(App::Mode::Window, 0, renderThread);
+        if(cubeCount) app->spawnCubes(std::strtoul(cubeCount, nullptr, 10));
     }
-    {
+    if(replayPath) {
+        BIGG_PROFILE_RUN_SCOPE("Replay");
+        Recorder::ReplayStats stats = Recorder::runReplay(replayPath);
+        // printed directly since logging is compiled out of release builds
+        fmt::print("Replayed {:d} frames in {:.3f}s: mean {:.3f}ms, min {:.3f}ms, p50 {:.3f}ms, p95 {:.3f}ms, p99 {:.3f}ms, max {:.3f}ms\n",
+                   stats.m_frames, stats.m_total, stats.m_mean * 1e3, stats.m_min * 1e3, stats.m_p50 * 1e3,
+                   stats.m_p95 * 1e3, stats.m_p99 * 1e3, stats.m_max * 1e3);
+        result = stats.m_frames > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    } else {
         BIGG_PROFILE_RUN_SCOPE("Run");
+        if(recordPath) Recorder::startRecording(recordPath);
+        Context::setHighFrequencyInput(highFrequencyInput);
         result = Context::run();
+        Recorder::stopRecording();
     }
     {
         BIGG_PROFILE_SHUTDOWN_SCOPE("Shutdown");